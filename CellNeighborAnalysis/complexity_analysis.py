@@ -0,0 +1,154 @@
+import os
+import re
+import sys
+import argparse
+import subprocess
+import tempfile
+import numpy as np
+import pandas as pd
+
+# ex/ 下的测试数据生成脚本
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), 'ex'))
+from generate_testdata_gauss import generate_test_data_clustered
+from generate_testdata_linear import generate_linear_data, generate_extreme_sparse_data
+from generate_data_ex import generate_test_data_extreme_clusters
+
+# 报告中的算法名称与 main 输出中的标签
+ALGORITHMS = [
+    ('brute_force', '暴力搜索', 'Brute Force'),
+    ('kd_tree', 'KD树搜索', 'KD-Tree'),
+    ('grid_search', '网格搜索', 'Grid Search'),
+    ('ball_tree', '球树搜索', 'Ball-Tree'),
+]
+
+DEFAULT_SIZES = [1000, 2000, 5000, 8000, 10000, 15000, 20000, 50000, 80000, 100000]
+
+
+def generate_uniform(num_cells, A_ratio=0.3, seed=2025):
+    """与 generate_testdata.py 相同的均匀分布数据"""
+    rng = np.random.default_rng(seed)
+    return pd.DataFrame({
+        'cellid': np.arange(num_cells),
+        'x': rng.uniform(0, 100, size=num_cells),
+        'y': rng.uniform(0, 100, size=num_cells),
+        'celltype': np.where(rng.random(num_cells) < A_ratio, 'A', 'B'),
+    })
+
+
+LINEAR_TYPES = ['single_line', 'multi_lines', 'cross_lines', 'spiral', 'sine_wave']
+
+# --dist 可选的分布：名称 -> 生成函数(num_cells)，种子与各生成脚本的默认值一致
+DISTRIBUTIONS = {
+    'uniform': generate_uniform,
+    'gauss': lambda n: generate_test_data_clustered(num_cells=n),
+    'extreme_sparse': lambda n: generate_extreme_sparse_data(num_cells=n),
+    'extreme_clusters': lambda n: generate_test_data_extreme_clusters(num_cells=n)[0],
+}
+for _t in LINEAR_TYPES:
+    DISTRIBUTIONS[_t] = lambda n, t=_t: generate_linear_data(num_cells=n, distribution_type=t)
+
+
+def run_main(exe, df):
+    """在临时目录中运行 main，解析 Algorithm Performance Report 中的耗时（微秒）"""
+    with tempfile.TemporaryDirectory() as work_dir:
+        df.to_csv(os.path.join(work_dir, 'test_cells.csv'), index=False)
+        out = subprocess.run([os.path.abspath(exe)], cwd=work_dir,
+                             capture_output=True, text=True, check=True).stdout
+    if 'All algorithms produce identical results!' not in out:
+        print(f'警告: {len(df)} 个细胞的数据上各算法结果不一致，耗时仅供参考', file=sys.stderr)
+    times = {}
+    for key, _, label in ALGORITHMS:
+        m = re.search(r'^' + re.escape(label) + r':\s+(\d+) us', out, re.M)
+        times[key] = int(m.group(1)) if m else np.nan
+    return times
+
+
+def r_squared(y, y_pred):
+    ss_res = np.sum((y - y_pred) ** 2)
+    ss_tot = np.sum((y - np.mean(y)) ** 2)
+    return 1 - ss_res / ss_tot
+
+
+def fit_models(n, t):
+    """对 log-log、线性、n log n、二次模型分别拟合"""
+    res = {}
+    slope, intercept = np.polyfit(np.log(n), np.log(t), 1)
+    res['log_log'] = {'slope': slope, 'intercept': intercept,
+                      'r_squared': r_squared(np.log(t), slope * np.log(n) + intercept),
+                      'complexity': f'O(n^{slope:.2f})'}
+    p = np.polyfit(n, t, 1)
+    res['linear'] = {'params': p, 'r_squared': r_squared(t, np.polyval(p, n)),
+                     'formula': f'T = {p[0]:.2e}*n + {p[1]:.2e}'}
+    nlogn = n * np.log(n)
+    p = np.polyfit(nlogn, t, 1)
+    res['nlogn'] = {'params': p, 'r_squared': r_squared(t, np.polyval(p, nlogn)),
+                    'formula': f'T = {p[0]:.2e}*n*log(n) + {p[1]:.2e}'}
+    p = np.polyfit(n, t, 2)
+    res['quadratic'] = {'params': p, 'r_squared': r_squared(t, np.polyval(p, n)),
+                        'formula': f'T = {p[0]:.2e}*n² + {p[1]:.2e}*n + {p[2]:.2e}'}
+    return res
+
+
+def write_report(df, report_path):
+    with open(report_path, 'w', encoding='utf-8') as f:
+        f.write('算法复杂度分析详细报告\n')
+        f.write('=' * 50 + '\n\n')
+        for dist, part in df.groupby('distribution', sort=False):
+            write_distribution_report(f, dist, part)
+
+
+def write_distribution_report(f, dist, df):
+    """按分布分别拟合，不同分布的耗时不混在一起"""
+    n = df['size'].values.astype(float)
+    f.write(f'数据分布: {dist}\n')
+    f.write('=' * 50 + '\n\n')
+    for key, name, _ in ALGORITHMS:
+        t = df[key].values.astype(float)
+        mask = t > 0
+        if mask.sum() < 3:
+            continue
+        res = fit_models(n[mask], t[mask])
+        f.write(f'{name} 分析结果:\n')
+        f.write('-' * 30 + '\n')
+        for model in ['log_log', 'linear', 'nlogn', 'quadratic']:
+            f.write(f'{model}: {res[model]}\n')
+        best = max(['linear', 'nlogn', 'quadratic'], key=lambda m: res[m]['r_squared'])
+        f.write(f'\n最佳拟合: {best}\n\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='运行各规模数据并拟合四种算法的复杂度')
+    parser.add_argument('--exe', type=str, default=os.path.join('核心代码', 'main.exe'),
+                        help='编译好的 main 程序路径')
+    parser.add_argument('--sizes', type=str, default=','.join(map(str, DEFAULT_SIZES)),
+                        help='逗号分隔的细胞总数列表')
+    parser.add_argument('--dist', type=str, default='uniform',
+                        help='逗号分隔的数据分布，可选: ' + ', '.join(DISTRIBUTIONS))
+    parser.add_argument('--results', type=str, default='test_results.csv',
+                        help='各规模耗时输出 (默认: test_results.csv)')
+    parser.add_argument('--report', type=str, default='complexity_analysis_report.txt',
+                        help='拟合报告输出 (默认: complexity_analysis_report.txt)')
+    args = parser.parse_args()
+
+    dists = args.dist.split(',')
+    for dist in dists:
+        if dist not in DISTRIBUTIONS:
+            parser.error(f'未知分布 {dist}，可选: ' + ', '.join(DISTRIBUTIONS))
+
+    rows = []
+    for dist in dists:
+        for size in [int(s) for s in args.sizes.split(',')]:
+            times = run_main(args.exe, DISTRIBUTIONS[dist](size))
+            times['distribution'] = dist
+            times['size'] = size
+            rows.append(times)
+            print(dist, size, times)
+
+    df = pd.DataFrame(rows, columns=['distribution', 'size'] + [key for key, _, _ in ALGORITHMS])
+    df.to_csv(args.results, index=False)
+    write_report(df, args.report)
+    print(f'耗时已保存到 {args.results}，拟合报告已保存到 {args.report}')
+
+
+if __name__ == '__main__':
+    main()
@@ -189,10 +189,17 @@ public:
                 }
             }
         }
-        // 按层扩展环形格子
-        int maxLayer = max(gridWidth, gridHeight);
+        // 按层扩展环形格子；查询点可能落在网格外（A 细胞不在 B 的包围盒内），
+        // 层数要足以覆盖从 (agx, agy) 到网格最远一角的距离
+        int maxLayer = max(max(abs(agx), abs(agx - (gridWidth - 1))),
+                           max(abs(agy), abs(agy - (gridHeight - 1)))) + 1;
         for (int layer = 1; layer < maxLayer; ++layer) {
-            bool anyVisited = false;
+            // 第 layer 层的格子都在以查询点所在格为中心、边长 2*layer-1 的方块之外，
+            // 与查询点的距离至少为 (layer-1)*cellSize；这个下界不小于当前最优时可提前结束
+            double ringMin = (layer - 1) * cellSize;
+            if (ringMin * ringMin >= bestDist2) {
+                break;
+            }
             // 左右列: gx = agx - layer, agx + layer; gy from agy - layer to agy + layer
             int gx_left = agx - layer;
             int gx_right = agx + layer;
@@ -202,7 +209,6 @@ public:
                 if (gx_left >= 0 && gx_left < gridWidth && gy >= 0 && gy < gridHeight) {
                     double boxDist2 = computeBoxMinDist2(queryCell, gx_left, gy);
                     if (boxDist2 < bestDist2) {
-                        anyVisited = true;
                         const vector<const Cell*>& bucket = gridArr[gx_left][gy];
                         for (size_t k = 0; k < bucket.size(); ++k) {
                             const Cell* pb = bucket[k];
@@ -218,7 +224,6 @@ public:
                 if (gx_right >= 0 && gx_right < gridWidth && gy >= 0 && gy < gridHeight) {
                     double boxDist2 = computeBoxMinDist2(queryCell, gx_right, gy);
                     if (boxDist2 < bestDist2) {
-                        anyVisited = true;
                         const vector<const Cell*>& bucket = gridArr[gx_right][gy];
                         for (size_t k = 0; k < bucket.size(); ++k) {
                             const Cell* pb = bucket[k];
@@ -240,7 +245,6 @@ public:
                 if (gx >= 0 && gx < gridWidth && gy_top >= 0 && gy_top < gridHeight) {
                     double boxDist2 = computeBoxMinDist2(queryCell, gx, gy_top);
                     if (boxDist2 < bestDist2) {
-                        anyVisited = true;
                         const vector<const Cell*>& bucket = gridArr[gx][gy_top];
                         for (size_t k = 0; k < bucket.size(); ++k) {
                             const Cell* pb = bucket[k];
@@ -256,7 +260,6 @@ public:
                 if (gx >= 0 && gx < gridWidth && gy_bottom >= 0 && gy_bottom < gridHeight) {
                     double boxDist2 = computeBoxMinDist2(queryCell, gx, gy_bottom);
                     if (boxDist2 < bestDist2) {
-                        anyVisited = true;
                         const vector<const Cell*>& bucket = gridArr[gx][gy_bottom];
                         for (size_t k = 0; k < bucket.size(); ++k) {
                             const Cell* pb = bucket[k];
@@ -269,10 +272,6 @@ public:
                     }
                 }
             }
-            // 如果本层没有任何格子被访问（即所有格子下界距离 >= bestDist2），则可提前结束
-            if (!anyVisited) {
-                break;
-            }
         }
         if (bestId < 0) {
             return make_pair(-1, -1.0);
@@ -348,22 +347,15 @@ public:
 };
 
 // 网格搜索算法
-vector<CellAnalysisResult> gridSearch(const vector<Cell>& A_cells, const vector<Cell>& B_cells, double radius = 10.0) {
-    vector<CellAnalysisResult> results;
+CellResultBuffer gridSearch(const vector<Cell>& A_cells, const vector<Cell>& B_cells, double radius = 10.0) {
+    CellResultBuffer results(A_cells, radius);
     
     if (B_cells.empty()) {
         // 如果没有B细胞，返回空结果
-        for (const auto& A_cell : A_cells) {
-            CellAnalysisResult result;
-            result.cellid = A_cell.id;
-            result.x = A_cell.x;
-            result.y = A_cell.y;
-            result.celltype = A_cell.type;
-            result.radius = radius;
-            result.nearest_B_id = -1;
-            result.nearest_B_dist = -1.0;
-            result.B_count_within_radius = 0;
-            results.push_back(result);
+        for (size_t i = 0; i < A_cells.size(); ++i) {
+            results.nearest_B_id[i] = -1;
+            results.nearest_B_dist[i] = -1.0;
+            results.B_count_within_radius[i] = 0;
         }
         return results;
     }
@@ -374,25 +366,20 @@ vector<CellAnalysisResult> gridSearch(const vector<Cell>& A_cells, const vector<
     // 构建空间网格，只插入B细胞
     SpatialGridOptimized grid(B_cells, cellSize);
     
-    // 对每个A细胞进行分析
-    for (const auto& A_cell : A_cells) {
-        CellAnalysisResult result;
-        result.cellid = A_cell.id;
-        result.x = A_cell.x;
-        result.y = A_cell.y;
-        result.celltype = A_cell.type;
-        result.radius = radius;
-        
-        // 查找最近的B细胞
-        pair<int, double> nearest = grid.findNearestB(A_cell);
-        result.nearest_B_id = nearest.first;
-        result.nearest_B_dist = nearest.second;
-        
-        // 计算半径内的B细胞数量
-        result.B_count_within_radius = grid.countBCellsWithinRadius(A_cell, radius);
-        
-        results.push_back(result);
-    }
+    // 对每个A细胞进行分析，各线程写入互不重叠的区间
+    parallelForRange(A_cells.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Cell& A_cell = A_cells[i];
+            
+            // 查找最近的B细胞
+            pair<int, double> nearest = grid.findNearestB(A_cell);
+            results.nearest_B_id[i] = nearest.first;
+            results.nearest_B_dist[i] = nearest.second;
+            
+            // 计算半径内的B细胞数量
+            results.B_count_within_radius[i] = grid.countBCellsWithinRadius(A_cell, radius);
+        }
+    });
     
     return results;
 }
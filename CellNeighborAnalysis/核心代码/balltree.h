@@ -0,0 +1,224 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "datastruct.h"
+using namespace std;
+
+// 球树（Ball Tree）
+// 每个节点用"质心 + 半径"的球包住自己的点集，按点集分布最宽的坐标轴在中位数处二分。
+// 实测（complexity_analysis.py --dist，见 test_results.csv）：均匀与 gauss 分布下网格搜索最快；
+// B 细胞沿直线、螺旋分布或挤在一角时网格退化严重，球树最快；团块分布下与 KD 树相当。
+// 存储采用隐式数组布局：节点 i 的孩子是 2i+1 与 2i+2，叶子数取 2 的幂，
+// 每个节点对应重排后坐标数组中的一段连续区间 [begin, end)，叶子内的点连续存放便于顺序扫描。
+class BallTree {
+public:
+    // 叶子桶容量
+    static const int LEAF_SIZE = 16;
+
+    // 与 kdtree 一样索引传入的全部细胞，由调用方负责只传 B 细胞
+    explicit BallTree(const vector<Cell>& cells) : numLeaves(1), firstLeaf(0) {
+        vector<int> order(cells.size());
+        for (size_t i = 0; i < cells.size(); ++i) {
+            order[i] = (int)i;
+        }
+        int n = (int)order.size();
+        int wantLeaves = (n + LEAF_SIZE - 1) / LEAF_SIZE;
+        while (numLeaves < wantLeaves) {
+            numLeaves *= 2;
+        }
+        firstLeaf = numLeaves - 1;
+        int numNodes = 2 * numLeaves - 1;
+        nodeBegin.assign(numNodes, 0);
+        nodeEnd.assign(numNodes, 0);
+        centerX.assign(numNodes, 0.0);
+        centerY.assign(numNodes, 0.0);
+        ballRadius.assign(numNodes, -1.0);
+
+        build(cells, order, 0, 0, n);
+
+        // 按重排后的顺序把坐标和编号拷成 SoA 数组
+        xs.resize(n);
+        ys.resize(n);
+        ids.resize(n);
+        for (int i = 0; i < n; ++i) {
+            const Cell& c = cells[order[i]];
+            xs[i] = c.x;
+            ys[i] = c.y;
+            ids[i] = c.id;
+        }
+        computeBalls();
+    }
+
+    // 查找最近 B 细胞；若无 B，则返回 (-1, -1.0)
+    pair<int, double> nearestNeighbor(const Cell& query) const {
+        int best_id = -1;
+        double best_dist2 = numeric_limits<double>::infinity();
+        if (!xs.empty()) {
+            searchNearest(0, query.x, query.y, best_id, best_dist2);
+        }
+        if (best_id < 0) {
+            return make_pair(-1, -1.0);
+        }
+        return make_pair(best_id, sqrt(best_dist2));
+    }
+
+    // 统计半径内 B 细胞数量
+    int countWithinRadius(const Cell& query, double radius) const {
+        int count = 0;
+        if (!xs.empty()) {
+            searchRange(0, query.x, query.y, radius, radius * radius, count);
+        }
+        return count;
+    }
+
+private:
+    int numLeaves;
+    int firstLeaf;
+    // 节点数组（隐式完全二叉树）
+    vector<int> nodeBegin, nodeEnd;
+    vector<double> centerX, centerY, ballRadius;
+    // 重排后的细胞（SoA）
+    vector<double> xs, ys;
+    vector<int> ids;
+
+    void build(const vector<Cell>& cells, vector<int>& order, int node, int begin, int end) {
+        nodeBegin[node] = begin;
+        nodeEnd[node] = end;
+        if (node >= firstLeaf) {
+            return;
+        }
+        // 选择分布最宽的坐标轴
+        double minX = numeric_limits<double>::infinity(), maxX = -minX;
+        double minY = minX, maxY = -minX;
+        for (int i = begin; i < end; ++i) {
+            const Cell& c = cells[order[i]];
+            minX = min(minX, c.x);
+            maxX = max(maxX, c.x);
+            minY = min(minY, c.y);
+            maxY = max(maxY, c.y);
+        }
+        bool splitX = (maxX - minX) >= (maxY - minY);
+        int mid = begin + (end - begin) / 2;
+        if (splitX) {
+            nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                        [&cells](int a, int b) { return cells[a].x < cells[b].x; });
+        } else {
+            nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                        [&cells](int a, int b) { return cells[a].y < cells[b].y; });
+        }
+        build(cells, order, 2 * node + 1, begin, mid);
+        build(cells, order, 2 * node + 2, mid, end);
+    }
+
+    // 自底向上计算每个节点的质心与半径
+    void computeBalls() {
+        for (int node = (int)nodeBegin.size() - 1; node >= 0; --node) {
+            int begin = nodeBegin[node];
+            int end = nodeEnd[node];
+            if (begin >= end) {
+                ballRadius[node] = -1.0;
+                continue;
+            }
+            double sx = 0.0, sy = 0.0;
+            for (int i = begin; i < end; ++i) {
+                sx += xs[i];
+                sy += ys[i];
+            }
+            double cx = sx / (end - begin);
+            double cy = sy / (end - begin);
+            double r2 = 0.0;
+            for (int i = begin; i < end; ++i) {
+                r2 = max(r2, squaredDistance(cx, cy, xs[i], ys[i]));
+            }
+            centerX[node] = cx;
+            centerY[node] = cy;
+            // 略微放大半径，防止舍入误差导致错误剪枝
+            ballRadius[node] = sqrt(r2) * (1.0 + 1e-12) + 1e-12;
+        }
+    }
+
+    // 查询点到节点球的最小距离平方，空节点返回无穷大
+    inline double ballMinDist2(int node, double qx, double qy) const {
+        double r = ballRadius[node];
+        if (r < 0.0) {
+            return numeric_limits<double>::infinity();
+        }
+        double d = sqrt(squaredDistance(qx, qy, centerX[node], centerY[node])) - r;
+        return d > 0.0 ? d * d : 0.0;
+    }
+
+    void searchNearest(int node, double qx, double qy, int& best_id, double& best_dist2) const {
+        if (node >= firstLeaf) {
+            // 叶子桶：顺序扫描连续存放的点
+            for (int i = nodeBegin[node]; i < nodeEnd[node]; ++i) {
+                double d2 = squaredDistance(qx, qy, xs[i], ys[i]);
+                if (d2 < best_dist2) {
+                    best_dist2 = d2;
+                    best_id = ids[i];
+                }
+            }
+            return;
+        }
+        int left = 2 * node + 1;
+        int right = left + 1;
+        double dl = ballMinDist2(left, qx, qy);
+        double dr = ballMinDist2(right, qx, qy);
+        // 先进入下界更小的孩子
+        if (dl <= dr) {
+            if (dl < best_dist2) searchNearest(left, qx, qy, best_id, best_dist2);
+            if (dr < best_dist2) searchNearest(right, qx, qy, best_id, best_dist2);
+        } else {
+            if (dr < best_dist2) searchNearest(right, qx, qy, best_id, best_dist2);
+            if (dl < best_dist2) searchNearest(left, qx, qy, best_id, best_dist2);
+        }
+    }
+
+    void searchRange(int node, double qx, double qy, double radius, double r2, int& count) const {
+        double br = ballRadius[node];
+        if (br < 0.0) {
+            return;
+        }
+        double dc = sqrt(squaredDistance(qx, qy, centerX[node], centerY[node]));
+        // 球与查询圆不相交，剪枝
+        if (dc - br > radius) {
+            return;
+        }
+        // 球完全落在查询圆内，整段计数
+        if (dc + br <= radius) {
+            count += nodeEnd[node] - nodeBegin[node];
+            return;
+        }
+        if (node >= firstLeaf) {
+            for (int i = nodeBegin[node]; i < nodeEnd[node]; ++i) {
+                if (squaredDistance(qx, qy, xs[i], ys[i]) <= r2) {
+                    count++;
+                }
+            }
+            return;
+        }
+        searchRange(2 * node + 1, qx, qy, radius, r2, count);
+        searchRange(2 * node + 2, qx, qy, radius, r2, count);
+    }
+};
+
+// 球树搜索算法
+CellResultBuffer ballTreeSearch(const vector<Cell>& A_cells,
+                                const vector<Cell>& B_cells,
+                                double radius = 10.0) {
+    CellResultBuffer results(A_cells, radius);
+    // 构造球树，传入的都是 B 细胞
+    const BallTree tree(B_cells);
+    parallelForRange(A_cells.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Cell& A_cell = A_cells[i];
+            pair<int, double> nn = tree.nearestNeighbor(A_cell);
+            results.nearest_B_id[i] = nn.first;
+            results.nearest_B_dist[i] = nn.second;
+            results.B_count_within_radius[i] = tree.countWithinRadius(A_cell, radius);
+        }
+    });
+    return results;
+}
@@ -8,6 +8,10 @@
 #include <algorithm>
 #include <limits>
 #include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
 using namespace std;
 
 struct Cell {
@@ -17,7 +21,7 @@ struct Cell {
     char type;
 };
 
-// 结果结构体，用于存储分析结果
+// 结果结构体，用于存储分析结果（按行展开，仅在输出时按需构造）
 struct CellAnalysisResult {
     int cellid;
     double x;
@@ -47,4 +51,135 @@ double calculateDistance(const Cell& cell1, const Cell& cell2) {
     double dx = cell1.x - cell2.x;
     double dy = cell1.y - cell2.y;
     return sqrt(dx * dx + dy * dy);
+}
+
+// 缓存行大小，结果数组按此对齐，线程分块也按此对齐以避免伪共享
+const size_t CACHE_LINE_SIZE = 64;
+
+// 定长、64 字节对齐的数组，一次性分配，不支持扩容
+template <typename T>
+class AlignedArray {
+public:
+    AlignedArray() : raw(NULL), ptr(NULL), n(0) {}
+    explicit AlignedArray(size_t count) : raw(NULL), ptr(NULL), n(0) {
+        allocate(count);
+    }
+    ~AlignedArray() {
+        free(raw);
+    }
+    AlignedArray(AlignedArray&& other) : raw(other.raw), ptr(other.ptr), n(other.n) {
+        other.raw = NULL;
+        other.ptr = NULL;
+        other.n = 0;
+    }
+    AlignedArray& operator=(AlignedArray&& other) {
+        if (this != &other) {
+            free(raw);
+            raw = other.raw;
+            ptr = other.ptr;
+            n = other.n;
+            other.raw = NULL;
+            other.ptr = NULL;
+            other.n = 0;
+        }
+        return *this;
+    }
+    AlignedArray(const AlignedArray&) = delete;
+    AlignedArray& operator=(const AlignedArray&) = delete;
+
+    void allocate(size_t count) {
+        free(raw);
+        raw = NULL;
+        ptr = NULL;
+        n = count;
+        if (count == 0) {
+            return;
+        }
+        // 多申请一个缓存行，再把起始地址向上取整到 64 字节边界
+        // 申请失败（或字节数溢出）时抛出 bad_alloc，不能留下空指针让各算法按 cells->size() 写入
+        if (count > (SIZE_MAX - CACHE_LINE_SIZE) / sizeof(T)) {
+            n = 0;
+            throw bad_alloc();
+        }
+        raw = malloc(count * sizeof(T) + CACHE_LINE_SIZE);
+        if (raw == NULL) {
+            n = 0;
+            throw bad_alloc();
+        }
+        uintptr_t addr = reinterpret_cast<uintptr_t>(raw);
+        addr = (addr + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+        ptr = reinterpret_cast<T*>(addr);
+    }
+
+    size_t size() const { return n; }
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+    T& operator[](size_t i) { return ptr[i]; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+
+private:
+    void* raw;
+    T* ptr;
+    size_t n;
+};
+
+// SoA 结果缓冲区：只保存算法算出的三列，x/y/type 直接引用输入的 A 细胞
+struct CellResultBuffer {
+    const vector<Cell>* cells;
+    double radius;
+    AlignedArray<int> nearest_B_id;
+    AlignedArray<double> nearest_B_dist;
+    AlignedArray<int> B_count_within_radius;
+
+    CellResultBuffer(const vector<Cell>& A_cells, double r)
+        : cells(&A_cells), radius(r),
+          nearest_B_id(A_cells.size()),
+          nearest_B_dist(A_cells.size()),
+          B_count_within_radius(A_cells.size()) {}
+
+    size_t size() const { return cells->size(); }
+    bool empty() const { return cells->empty(); }
+
+    // 还原某一行，用于输出与调试
+    CellAnalysisResult row(size_t i) const {
+        const Cell& c = (*cells)[i];
+        CellAnalysisResult result;
+        result.cellid = c.id;
+        result.x = c.x;
+        result.y = c.y;
+        result.celltype = c.type;
+        result.nearest_B_id = nearest_B_id[i];
+        result.nearest_B_dist = nearest_B_dist[i];
+        result.B_count_within_radius = B_count_within_radius[i];
+        result.radius = radius;
+        return result;
+    }
+};
+
+// 把 [0, n) 切成若干连续区间交给工作线程，func(begin, end) 处理一个区间。
+// 区间边界按 16 个元素对齐：int 数组正好 64 字节，double 数组 128 字节，
+// 因此不同线程写入的结果永远不会落在同一缓存行上。
+template <typename Func>
+void parallelForRange(size_t n, Func func) {
+    const size_t ALIGN_ELEMS = CACHE_LINE_SIZE / sizeof(int);
+    size_t numThreads = thread::hardware_concurrency();
+    if (numThreads == 0) {
+        numThreads = 1;
+    }
+    size_t chunk = (n + numThreads - 1) / numThreads;
+    chunk = (chunk + ALIGN_ELEMS - 1) / ALIGN_ELEMS * ALIGN_ELEMS;
+    if (numThreads == 1 || chunk >= n) {
+        func((size_t)0, n);
+        return;
+    }
+    vector<thread> workers;
+    for (size_t begin = chunk; begin < n; begin += chunk) {
+        size_t end = min(n, begin + chunk);
+        workers.push_back(thread(func, begin, end));
+    }
+    // 主线程负责第一段
+    func((size_t)0, min(n, chunk));
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
 }
\ No newline at end of file
@@ -30,10 +30,11 @@ public:
         destroy(root);
     }
 
-    pair<int, double> nearestNeighbor(const Cell& query) {
-        best_id = -1;
-        best_dist2 = numeric_limits<double>::infinity();
-        searchNearest(root, query, 0);
+    // 查询状态全部放在栈上，多个线程可以同时查询同一棵树
+    pair<int, double> nearestNeighbor(const Cell& query) const {
+        int best_id = -1;
+        double best_dist2 = numeric_limits<double>::infinity();
+        searchNearest(root, query, 0, best_id, best_dist2);
         if (best_id < 0) {
             // 没有 B 细胞
             return make_pair(-1, -1.0);
@@ -42,7 +43,7 @@ public:
         return make_pair(best_id, best_dist);
     }
 
-    int countWithinRadius(const Cell& query, double radius) {
+    int countWithinRadius(const Cell& query, double radius) const {
         double r2 = radius * radius;
         int count = 0;
         searchRange(root, query, r2, count);
@@ -51,8 +52,6 @@ public:
 
 private:
     kdnode* root;
-    int best_id;
-    double best_dist2;
 
     kdnode* build(vector<Cell>& points, int depth) {
         if (points.empty()) {
@@ -161,7 +160,8 @@ private:
         delete node;
     }
     
-    void searchNearest(kdnode* node, const Cell& query, int depth) {
+    void searchNearest(kdnode* node, const Cell& query, int depth,
+                       int& best_id, double& best_dist2) const {
         if (node == NULL) {
             return;
         }
@@ -193,17 +193,17 @@ private:
         }
         // 先搜索 near 分支
         if (nearChild != NULL) {
-            searchNearest(nearChild, query, depth + 1);
+            searchNearest(nearChild, query, depth + 1, best_id, best_dist2);
         }
         if (farChild != NULL) {
             double delta2 = delta * delta;
             if (delta2 < best_dist2) {
-                searchNearest(farChild, query, depth + 1);
+                searchNearest(farChild, query, depth + 1, best_id, best_dist2);
             }
         }
     }
 
-    void searchRange(kdnode* node, const Cell& query, double r2, int& count) {
+    void searchRange(kdnode* node, const Cell& query, double r2, int& count) const {
         if (node == NULL) {
             return;
         }
@@ -242,29 +242,28 @@ private:
 };
 
 // KD树优化算法
-vector<CellAnalysisResult> kdTreeSearch(const vector<Cell>& A_cells,
-                                        const vector<Cell>& B_cells,
-                                        double radius = 10.0) {
-    vector<CellAnalysisResult> results;
+CellResultBuffer kdTreeSearch(const vector<Cell>& A_cells,
+                              const vector<Cell>& B_cells,
+                              double radius = 10.0) {
+    CellResultBuffer results(A_cells, radius);
     if (B_cells.empty()) {
+        for (size_t i = 0; i < A_cells.size(); ++i) {
+            results.nearest_B_id[i] = -1;
+            results.nearest_B_dist[i] = -1.0;
+            results.B_count_within_radius[i] = 0;
+        }
         return results;
     }
     // 构造 KD-树，只插入 B 细胞
-    kdtree tree(B_cells);
-    results.reserve(A_cells.size());
-    for (size_t i = 0; i < A_cells.size(); ++i) {
-        const Cell& A_cell = A_cells[i];
-        CellAnalysisResult result;
-        result.cellid = A_cell.id;
-        result.x = A_cell.x;
-        result.y = A_cell.y;
-        result.celltype = A_cell.type;
-        result.radius = radius;
-        pair<int, double> nn = tree.nearestNeighbor(A_cell);
-        result.nearest_B_id = nn.first;
-        result.nearest_B_dist = nn.second;
-        result.B_count_within_radius = tree.countWithinRadius(A_cell, radius);
-        results.push_back(result);
-    }
+    const kdtree tree(B_cells);
+    parallelForRange(A_cells.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Cell& A_cell = A_cells[i];
+            pair<int, double> nn = tree.nearestNeighbor(A_cell);
+            results.nearest_B_id[i] = nn.first;
+            results.nearest_B_dist[i] = nn.second;
+            results.B_count_within_radius[i] = tree.countWithinRadius(A_cell, radius);
+        }
+    });
     return results;
 }
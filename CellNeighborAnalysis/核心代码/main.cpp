@@ -11,6 +11,7 @@
 #include "bruce.h"
 #include "kdtree.h"
 #include "Grid.h"
+#include "balltree.h"
 using namespace std;
 
 // 读取CSV文件
@@ -58,7 +59,7 @@ vector<Cell> readCellsFromCSV(const string& filename) {
 
 
 // 将结果写入CSV文件
-void writeResultsToCSV(const vector<CellAnalysisResult>& results, const string& filename) {
+void writeResultsToCSV(const CellResultBuffer& results, const string& filename) {
     ofstream file(filename);
     
     if (!file.is_open()) {
@@ -70,7 +71,8 @@ void writeResultsToCSV(const vector<CellAnalysisResult>& results, const string&
     file << "cellid,x,y,celltype,nearest_B_id,nearest_B_dist,B_count_within_R,radius\n";
     
     // 写入数据
-    for (const auto& result : results) {
+    for (size_t i = 0; i < results.size(); ++i) {
+        CellAnalysisResult result = results.row(i);
         file << result.cellid << ","
              << result.x << ","
              << result.y << ","
@@ -86,7 +88,7 @@ void writeResultsToCSV(const vector<CellAnalysisResult>& results, const string&
 }
 
 // 打印统计信息
-void printStatistics(const vector<CellAnalysisResult>& results) {
+void printStatistics(const CellResultBuffer& results) {
     if (results.empty()) {
         cout << "No result data" << endl;
         return;
@@ -97,11 +99,11 @@ void printStatistics(const vector<CellAnalysisResult>& results) {
     double max_dist = 0.0;
     int total_B_count = 0;
     
-    for (const auto& result : results) {
-        total_dist += result.nearest_B_dist;
-        min_dist = min(min_dist, result.nearest_B_dist);
-        max_dist = max(max_dist, result.nearest_B_dist);
-        total_B_count += result.B_count_within_radius;
+    for (size_t i = 0; i < results.size(); ++i) {
+        total_dist += results.nearest_B_dist[i];
+        min_dist = min(min_dist, results.nearest_B_dist[i]);
+        max_dist = max(max_dist, results.nearest_B_dist[i]);
+        total_B_count += results.B_count_within_radius[i];
     }
     
     cout << "\n=== Analysis Statistics ===" << endl;
@@ -110,7 +112,7 @@ void printStatistics(const vector<CellAnalysisResult>& results) {
     cout << "  Average distance: " << total_dist / results.size() << endl;
     cout << "  Minimum distance: " << min_dist << endl;
     cout << "  Maximum distance: " << max_dist << endl;
-    cout << "B cells within radius statistics (radius=" << results[0].radius << "):" << endl;
+    cout << "B cells within radius statistics (radius=" << results.radius << "):" << endl;
     cout << "  Total count: " << total_B_count << endl;
     cout << "  Average per A cell: " << (double)total_B_count / results.size() << " B cells" << endl;
 }
@@ -151,7 +153,7 @@ int main() {
     /*
     cout << "\n=== Testing Brute Force Algorithm ===" << endl;
     auto start_time1 = chrono::high_resolution_clock::now();
-    vector<CellAnalysisResult> results = bruteForceSearch(A_cells, B_cells, radius);
+    CellResultBuffer results = bruteForceSearch(A_cells, B_cells, radius);
     auto end_time1 = chrono::high_resolution_clock::now();
     auto duration_ms1 = chrono::duration_cast<chrono::milliseconds>(end_time1 - start_time1);
     auto duration_us1 = chrono::duration_cast<chrono::microseconds>(end_time1 - start_time1);
@@ -162,7 +164,7 @@ int main() {
     /*
     cout << "\n=== Testing KD-Tree Algorithm ===" << endl;
     auto start_time2 = chrono::high_resolution_clock::now();
-    vector<CellAnalysisResult> results = kdTreeSearch(A_cells, B_cells, radius);
+    CellResultBuffer results = kdTreeSearch(A_cells, B_cells, radius);
     auto end_time2 = chrono::high_resolution_clock::now();
     auto duration_ms2 = chrono::duration_cast<chrono::milliseconds>(end_time2 - start_time2);
     auto duration_us2 = chrono::duration_cast<chrono::microseconds>(end_time2 - start_time2);
@@ -173,13 +175,24 @@ int main() {
     /*
     cout << "\n=== Testing Grid Search Algorithm ===" << endl;
     auto start_time3 = chrono::high_resolution_clock::now();
-    vector<CellAnalysisResult> results = gridSearch(A_cells, B_cells, radius);
+    CellResultBuffer results = gridSearch(A_cells, B_cells, radius);
     auto end_time3 = chrono::high_resolution_clock::now();
     auto duration_ms3 = chrono::duration_cast<chrono::milliseconds>(end_time3 - start_time3);
     auto duration_us3 = chrono::duration_cast<chrono::microseconds>(end_time3 - start_time3);
     cout << "Grid Search completed, time elapsed: " << duration_ms3.count() << " ms (" << duration_us3.count() << " microseconds)" << endl;
     */
 
+    // 选项4：球树算法（适合高度聚集的分布）
+    /*
+    cout << "\n=== Testing Ball-Tree Algorithm ===" << endl;
+    auto start_time4 = chrono::high_resolution_clock::now();
+    CellResultBuffer results = ballTreeSearch(A_cells, B_cells, radius);
+    auto end_time4 = chrono::high_resolution_clock::now();
+    auto duration_ms4 = chrono::duration_cast<chrono::milliseconds>(end_time4 - start_time4);
+    auto duration_us4 = chrono::duration_cast<chrono::microseconds>(end_time4 - start_time4);
+    cout << "Ball-Tree completed, time elapsed: " << duration_ms4.count() << " ms (" << duration_us4.count() << " microseconds)" << endl;
+    */
+
     // 多算法性能比较（解注释以启用）
  
     // 运行所有算法进行比较
@@ -187,33 +200,41 @@ int main() {
     
     // 1. 暴力搜索
     auto start_bf = chrono::high_resolution_clock::now();
-    vector<CellAnalysisResult> results_bf = bruteForceSearch(A_cells, B_cells, radius);
+    CellResultBuffer results_bf = bruteForceSearch(A_cells, B_cells, radius);
     auto end_bf = chrono::high_resolution_clock::now();
     auto duration_bf = chrono::duration_cast<chrono::microseconds>(end_bf - start_bf);
     
     // 2. KD树
     auto start_kd = chrono::high_resolution_clock::now();
-    vector<CellAnalysisResult> results_kd = kdTreeSearch(A_cells, B_cells, radius);
+    CellResultBuffer results_kd = kdTreeSearch(A_cells, B_cells, radius);
     auto end_kd = chrono::high_resolution_clock::now();
     auto duration_kd = chrono::duration_cast<chrono::microseconds>(end_kd - start_kd);
     
     // 3. 网格搜索
     auto start_grid = chrono::high_resolution_clock::now();
-    vector<CellAnalysisResult> results_grid = gridSearch(A_cells, B_cells, radius);
+    CellResultBuffer results_grid = gridSearch(A_cells, B_cells, radius);
     auto end_grid = chrono::high_resolution_clock::now();
     auto duration_grid = chrono::duration_cast<chrono::microseconds>(end_grid - start_grid);
     
+    // 4. 球树
+    auto start_ball = chrono::high_resolution_clock::now();
+    CellResultBuffer results_ball = ballTreeSearch(A_cells, B_cells, radius);
+    auto end_ball = chrono::high_resolution_clock::now();
+    auto duration_ball = chrono::duration_cast<chrono::microseconds>(end_ball - start_ball);
+    
     // 性能报告
     cout << "\nAlgorithm Performance Report:" << endl;
     cout << "Brute Force:  " << duration_bf.count() << " us" << endl;
     cout << "KD-Tree:      " << duration_kd.count() << " us" << endl;
     cout << "Grid Search:  " << duration_grid.count() << " us" << endl;
+    cout << "Ball-Tree:    " << duration_ball.count() << " us" << endl;
     
     // 计算加速比
     if (duration_bf.count() > 0) {
         cout << "\nSpeedup vs Brute Force:" << endl;
         cout << "KD-Tree:     " << (double)duration_bf.count() / duration_kd.count() << "x" << endl;
         cout << "Grid Search: " << (double)duration_bf.count() / duration_grid.count() << "x" << endl;
+        cout << "Ball-Tree:   " << (double)duration_bf.count() / duration_ball.count() << "x" << endl;
     }
     
     // 结果验证
@@ -223,10 +244,10 @@ int main() {
     // 验证KD树与暴力搜索
     if (results_bf.size() == results_kd.size()) {
         for (size_t i = 0; i < results_bf.size(); i++) {
-            if (results_bf[i].nearest_B_id != results_kd[i].nearest_B_id ||
-                abs(results_bf[i].nearest_B_dist - results_kd[i].nearest_B_dist) > 1e-6 ||
-                results_bf[i].B_count_within_radius != results_kd[i].B_count_within_radius) {
-                cout << " KD-Tree mismatch at cell " << results_bf[i].cellid << endl;
+            if (results_bf.nearest_B_id[i] != results_kd.nearest_B_id[i] ||
+                abs(results_bf.nearest_B_dist[i] - results_kd.nearest_B_dist[i]) > 1e-6 ||
+                results_bf.B_count_within_radius[i] != results_kd.B_count_within_radius[i]) {
+                cout << " KD-Tree mismatch at cell " << A_cells[i].id << endl;
                 all_match = false;
                 break;
             }
@@ -236,10 +257,23 @@ int main() {
     // 验证网格搜索与暴力搜索
     if (results_bf.size() == results_grid.size()) {
         for (size_t i = 0; i < results_bf.size(); i++) {
-            if (results_bf[i].nearest_B_id != results_grid[i].nearest_B_id ||
-                abs(results_bf[i].nearest_B_dist - results_grid[i].nearest_B_dist) > 1e-6 ||
-                results_bf[i].B_count_within_radius != results_grid[i].B_count_within_radius) {
-                cout << "Grid Search mismatch at cell " << results_bf[i].cellid << endl;
+            if (results_bf.nearest_B_id[i] != results_grid.nearest_B_id[i] ||
+                abs(results_bf.nearest_B_dist[i] - results_grid.nearest_B_dist[i]) > 1e-6 ||
+                results_bf.B_count_within_radius[i] != results_grid.B_count_within_radius[i]) {
+                cout << "Grid Search mismatch at cell " << A_cells[i].id << endl;
+                all_match = false;
+                break;
+            }
+        }
+    }
+    
+    // 验证球树与暴力搜索
+    if (results_bf.size() == results_ball.size()) {
+        for (size_t i = 0; i < results_bf.size(); i++) {
+            if (results_bf.nearest_B_id[i] != results_ball.nearest_B_id[i] ||
+                abs(results_bf.nearest_B_dist[i] - results_ball.nearest_B_dist[i]) > 1e-6 ||
+                results_bf.B_count_within_radius[i] != results_ball.B_count_within_radius[i]) {
+                cout << "Ball-Tree mismatch at cell " << A_cells[i].id << endl;
                 all_match = false;
                 break;
             }
@@ -251,7 +285,7 @@ int main() {
     }
     
     // 使用暴力搜索的结果作为标准答案
-    vector<CellAnalysisResult> results = results_bf;
+    const CellResultBuffer& results = results_bf;
 
     
     // 输出统计信息
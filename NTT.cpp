@@ -1,97 +1,1235 @@
 #include <bits/stdc++.h>
 using namespace std;
 using ll = long long;
+using u32 = uint32_t;
+using u64 = uint64_t;
 
 const int MOD = 998244353;      
 const int PRIMITIVE_ROOT = 3;
 
-ll modexp(ll a, ll e) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NTT_HAS_AVX2_KERNEL 1
+#endif
+
+ll modexp(ll a, ll e, ll mod = MOD) {
 	ll result = 1;
 	while (e > 0) {
-		if (e % 2 == 1) result = (result * a) % MOD;
-		a = (a * a) % MOD;
+		if (e % 2 == 1) result = (result * a) % mod;
+		a = (a * a) % mod;
 		e /= 2;
 	}
 	return result;
 }
 
-void ntt(vector<ll> &a, bool invert) {
-	int n = a.size();
+// 位逆序置换表，revTables[k] 对应长度 2^k，按需生成后缓存，各模数共用
+vector<vector<int>> revTables;
+
+const vector<int> &bitReverse(int n) {
 	int logn = 0;
-	int pow2 = 1;
-	while (pow2 < n) {
-		pow2 *= 2;
-		logn++;
+	while ((1 << logn) < n) logn++;
+	if ((int)revTables.size() <= logn) revTables.resize(logn + 1);
+	vector<int> &rev = revTables[logn];
+	if (rev.empty()) {
+		rev.resize(n);
+		rev[0] = 0;
+		for (int i = 1; i < n; i++) rev[i] = (rev[i >> 1] >> 1) | ((i & 1) << (logn - 1));
 	}
+	return rev;
+}
+
+// 固定大小的线程池，各处的 parallelFor 都交给它执行，线程只创建一次。
+// main 按 --threads 设置线程数（默认为 hardware_concurrency），未设置时全部在调用线程中执行。
+class ThreadPool {
+public:
+	~ThreadPool() { stop(); }
 	
-	vector<int> rev(n);
-	for (int i = 0; i < n; i++) {
-		int x = i;
-		int r = 0;
-		for (int k = 0; k < logn; k++) {
-			int bit = x % 2;    
-			r = r * 2 + bit;    
-			x = x / 2;         
+	// 线程总数，含调用线程；1 表示单线程
+	int size() const { return (int)workers.size() + 1; }
+	
+	void resize(int threads) {
+		stop();
+		stopping = false;
+		for (int k = 1; k < threads; k++) workers.emplace_back([this] { workerLoop(); });
+	}
+	
+	// 把 [0, count) 切成若干段，由调用线程和池中线程按原子计数领取，执行 f(begin, end)，全部完成后返回。
+	// 调用线程自己也领取，即使池中线程都在忙（例如段内再次调用 parallelFor）也能独自做完，不会死锁
+	void run(int count, const function<void(int, int)> &f) {
+		int chunks = min(count, 4 * size());
+		if (chunks <= 1 || workers.empty()) {
+			if (count > 0) f(0, count);
+			return;
+		}
+		auto job = make_shared<Job>();
+		job->f = &f;
+		job->count = count;
+		job->chunks = chunks;
+		{
+			lock_guard<mutex> lk(m);
+			jobs.push_back(job);
 		}
-		rev[i] = r;
+		cv.notify_all();
+		work(*job);
+		{
+			unique_lock<mutex> lk(job->m);
+			job->cv.wait(lk, [&] { return job->done == job->chunks; });
+		}
+		lock_guard<mutex> lk(m);
+		auto it = find(jobs.begin(), jobs.end(), job);
+		if (it != jobs.end()) jobs.erase(it);
 	}
-	for (int i = 0; i < n; i++) {
-		if (i < rev[i]) swap(a[i], a[rev[i]]);
+	
+private:
+	struct Job {
+		const function<void(int, int)> *f;
+		int count, chunks;
+		atomic<int> next{0}, done{0};
+		mutex m;
+		condition_variable cv;
+	};
+	
+	vector<thread> workers;
+	deque<shared_ptr<Job>> jobs;
+	mutex m;
+	condition_variable cv;
+	bool stopping = false;
+	
+	// 领取并执行 job 中尚未开始的段，最后一段完成时唤醒等待的调用线程
+	static void work(Job &job) {
+		int c;
+		while ((c = job.next++) < job.chunks) {
+			(*job.f)((ll)job.count * c / job.chunks, (ll)job.count * (c + 1) / job.chunks);
+			if (++job.done == job.chunks) {
+				lock_guard<mutex> lk(job.m);
+				job.cv.notify_all();
+			}
+		}
 	}
 	
-	int len = 1;
-	while (len < n) {
-		ll wlen = modexp(PRIMITIVE_ROOT, (MOD - 1) / (2 * len));
-		if (invert) {
-			wlen = modexp(wlen, MOD - 2);
+	void workerLoop() {
+		for (;;) {
+			shared_ptr<Job> job;
+			{
+				unique_lock<mutex> lk(m);
+				cv.wait(lk, [&] { return stopping || !jobs.empty(); });
+				if (stopping) return;
+				job = jobs.front();
+				// 各段都已被领取的任务移出队列
+				if (job->next >= job->chunks) {
+					jobs.pop_front();
+					continue;
+				}
+			}
+			work(*job);
+		}
+	}
+	
+	void stop() {
+		{
+			lock_guard<mutex> lk(m);
+			stopping = true;
+		}
+		cv.notify_all();
+		for (auto &t : workers) t.join();
+		workers.clear();
+	}
+};
+
+ThreadPool pool;
+
+template <typename F>
+void parallelFor(int count, F f) {
+	pool.run(count, f);
+}
+
+// 分块转置：src 为 rows × cols 的行主序矩阵，dst 为 cols × rows。
+// 按 TILE × TILE 的小块读写，源和目标都只在少数几个缓存行内跳动；各块行分给多个线程
+template <typename T>
+void transposeBlocked(const T *src, T *dst, int rows, int cols) {
+	const int TILE = 8;
+	parallelFor((rows + TILE - 1) / TILE, [=](int lo, int hi) {
+		for (int bi = lo * TILE; bi < min(rows, hi * TILE); bi += TILE) {
+			for (int bj = 0; bj < cols; bj += TILE) {
+				int ei = min(rows, bi + TILE), ej = min(cols, bj + TILE);
+				for (int i = bi; i < ei; i++) {
+					for (int j = bj; j < ej; j++) dst[(size_t)j * rows + i] = src[(size_t)i * cols + j];
+				}
+			}
+		}
+	});
+}
+
+#ifdef NTT_HAS_AVX2_KERNEL
+// 8 个 32 位通道的 Montgomery 乘法：奇偶通道分别用 _mm256_mul_epu32 得到 64 位乘积，
+// 约简后高 32 位即结果，再拼回 8 个通道。ninv、mod 为广播后的常数，结果在 [0, 2·mod)
+__attribute__((target("avx2")))
+inline __m256i montMulAvx2(__m256i a, __m256i b, __m256i ninv, __m256i mod) {
+	__m256i even = _mm256_mul_epu32(a, b);
+	__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+	even = _mm256_add_epi64(even, _mm256_mul_epu32(_mm256_mul_epu32(even, ninv), mod));
+	odd = _mm256_add_epi64(odd, _mm256_mul_epu32(_mm256_mul_epu32(odd, ninv), mod));
+	return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+// [0, 2·m) 收缩到 [0, m)（m2 为广播后的 m）：x < m 时 x - m 回绕成大数，取无符号最小值即可
+__attribute__((target("avx2")))
+inline __m256i shrinkAvx2(__m256i x, __m256i m) {
+	return _mm256_min_epu32(x, _mm256_sub_epi32(x, m));
+}
+#endif
+
+// Montgomery 形式的 NTT 引擎，按模数实例化。P 为 NTT 友好素数（P - 1 含足够多的因子 2），
+// G 为其原根；x 存为 x·R mod P，R = 2^32，乘法只用乘法和移位，不做除法。
+// 惰性约简：变换的输入、输出和中间值都只保证在 [0, 2·P)，要求 4·P < 2^32。
+// 各模数的单位根表互相独立，不同模数的变换可以在不同线程中同时进行。
+template <u32 P, u32 G>
+struct MontNtt {
+	static_assert(4ULL * P < (1ULL << 32), "Montgomery NTT needs 4 * P < 2^32");
+	
+	// -P^{-1} mod 2^32（牛顿迭代，每次精度翻倍）与 R^2 mod P
+	static constexpr u32 negInv() {
+		u32 inv = P;
+		for (int i = 0; i < 4; i++) inv *= 2 - P * inv;
+		return -inv;
+	}
+	static constexpr u32 NINV = negInv();
+	static constexpr u32 R2 = (u64)((1ULL << 32) % P) * ((1ULL << 32) % P) % P;
+	static constexpr u32 P2 = 2 * P;
+	
+	// t < P·2^32 时返回 t / R mod P，结果在 [0, 2·P)
+	static u32 reduce(u64 t) {
+		u32 m = (u32)t * NINV;
+		return (t + (u64)m * P) >> 32;
+	}
+	// [0, 2·P) 收缩到 [0, P)
+	static u32 shrink(u32 x) { return x >= P ? x - P : x; }
+	// [0, 4·P) 收缩到 [0, 2·P)
+	static u32 shrink2(u32 x) { return x >= P2 ? x - P2 : x; }
+	static u32 mul(u32 a, u32 b) { return shrink(reduce((u64)a * b)); }
+	static u32 toMont(ll x) {
+		x %= P;
+		return mul(x < 0 ? x + P : x, R2);
+	}
+	// 转回普通形式并乘上 c（c 为普通形式）：一次约简同时完成除以 R
+	static u32 fromMont(u32 x, u32 c = 1) { return shrink(reduce((u64)x * c)); }
+	
+	// 单位根表：roots()[len + j] = G^{j·(P-1)/(2·len)}，即长度为 2·len 的蝶形层所需的全部旋转因子。
+	// 每层只调用一次 modexp，其余由相邻项相乘得到（模运算是精确的，不存在误差累积）；表只增不减。
+	static vector<u32> &roots() {
+		static vector<u32> table{0, toMont(1)};
+		return table;
+	}
+	
+	static void prepareRoots(int n) {
+		vector<u32> &r = roots();
+		int have = r.size();
+		if (have >= n) return;
+		r.resize(n);
+		for (int len = have; len < n; len *= 2) {
+			u32 step = toMont(modexp(G, (P - 1) / (2 * len), P));
+			r[len] = toMont(1);
+			for (int j = 1; j < len; j++) r[len + j] = mul(r[len + j - 1], step);
+		}
+	}
+	
+	// 第 len 层中编号在 [tlo, thi) 内的蝶形，编号 t 对应第 t / len 组的第 t % len 对，标量版本。
+	// u + v 与 u - v + 2·P 都在 [0, 4·P) 内，各做一次条件减法即可
+	static void stageRangeScalar(u32 *f, int len, int tlo, int thi) {
+		const u32 *w = roots().data() + len;
+		int lg = __builtin_ctz(len);
+		for (int t = tlo; t < thi;) {
+			int j0 = t & (len - 1), jend = min(len, j0 + (thi - t));
+			u32 *x = f + ((size_t)(t >> lg) << (lg + 1));
+			u32 *y = x + len;
+			for (int j = j0; j < jend; j++) {
+				u32 u = x[j];
+				u32 v = reduce((u64)y[j] * w[j]);
+				x[j] = shrink2(u + v);
+				y[j] = shrink2(u + P2 - v);
+			}
+			t += jend - j0;
+		}
+	}
+	
+#ifdef NTT_HAS_AVX2_KERNEL
+	// AVX2 版本：len >= 8 的层每次处理 8 对蝶形（此时 tlo、thi 须为 8 的倍数），更短的层与标量版本相同
+	__attribute__((target("avx2")))
+	static void stageRangeAvx2(u32 *f, int len, int tlo, int thi) {
+		if (len < 8) {
+			stageRangeScalar(f, len, tlo, thi);
+			return;
+		}
+		const __m256i ninv = _mm256_set1_epi32(NINV);
+		const __m256i mod = _mm256_set1_epi32(P);
+		const __m256i mod2 = _mm256_set1_epi32(P2);
+		const u32 *w = roots().data() + len;
+		int lg = __builtin_ctz(len);
+		for (int t = tlo; t < thi;) {
+			int j0 = t & (len - 1), jend = min(len, j0 + (thi - t));
+			u32 *x = f + ((size_t)(t >> lg) << (lg + 1));
+			u32 *y = x + len;
+			for (int j = j0; j < jend; j += 8) {
+				__m256i u = _mm256_loadu_si256((const __m256i *)(x + j));
+				__m256i v = _mm256_loadu_si256((const __m256i *)(y + j));
+				v = montMulAvx2(v, _mm256_loadu_si256((const __m256i *)(w + j)), ninv, mod);
+				_mm256_storeu_si256((__m256i *)(x + j), shrinkAvx2(_mm256_add_epi32(u, v), mod2));
+				_mm256_storeu_si256((__m256i *)(y + j), shrinkAvx2(_mm256_sub_epi32(_mm256_add_epi32(u, mod2), v), mod2));
+			}
+			t += jend - j0;
+		}
+	}
+#endif
+	
+	// 运行时按 CPU 选择蝶形实现，只判断一次
+	static void (*chooseStageRange())(u32 *, int, int, int) {
+#ifdef NTT_HAS_AVX2_KERNEL
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) return stageRangeAvx2;
+#endif
+		return stageRangeScalar;
+	}
+	
+	static void stageRange(u32 *f, int len, int tlo, int thi) {
+		static void (*const kernel)(u32 *, int, int, int) = chooseStageRange();
+		kernel(f, len, tlo, thi);
+	}
+	
+	// 自底向上逐层蝶形，整段一次做完，运算与 stageRange 相同，省去按编号换算组和位置的开销
+	static void stagesScalar(u32 *f, int n) {
+		for (int len = 1; len < n; len *= 2) {
+			const u32 *w = roots().data() + len;
+			for (int i = 0; i < n; i += 2 * len) {
+				u32 *x = f + i;
+				u32 *y = x + len;
+				for (int j = 0; j < len; j++) {
+					u32 u = x[j];
+					u32 v = reduce((u64)y[j] * w[j]);
+					x[j] = shrink2(u + v);
+					y[j] = shrink2(u + P2 - v);
+				}
+			}
+		}
+	}
+	
+#ifdef NTT_HAS_AVX2_KERNEL
+	__attribute__((target("avx2")))
+	static void stagesAvx2(u32 *f, int n) {
+		const __m256i ninv = _mm256_set1_epi32(NINV);
+		const __m256i mod = _mm256_set1_epi32(P);
+		const __m256i mod2 = _mm256_set1_epi32(P2);
+		for (int len = 1; len < n; len *= 2) {
+			const u32 *w = roots().data() + len;
+			for (int i = 0; i < n; i += 2 * len) {
+				u32 *x = f + i;
+				u32 *y = x + len;
+				if (len < 8) {
+					for (int j = 0; j < len; j++) {
+						u32 u = x[j];
+						u32 v = reduce((u64)y[j] * w[j]);
+						x[j] = shrink2(u + v);
+						y[j] = shrink2(u + P2 - v);
+					}
+					continue;
+				}
+				for (int j = 0; j < len; j += 8) {
+					__m256i u = _mm256_loadu_si256((const __m256i *)(x + j));
+					__m256i v = _mm256_loadu_si256((const __m256i *)(y + j));
+					v = montMulAvx2(v, _mm256_loadu_si256((const __m256i *)(w + j)), ninv, mod);
+					_mm256_storeu_si256((__m256i *)(x + j), shrinkAvx2(_mm256_add_epi32(u, v), mod2));
+					_mm256_storeu_si256((__m256i *)(y + j), shrinkAvx2(_mm256_sub_epi32(_mm256_add_epi32(u, mod2), v), mod2));
+				}
+			}
+		}
+	}
+#endif
+	
+	static void (*chooseStages())(u32 *, int) {
+#ifdef NTT_HAS_AVX2_KERNEL
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) return stagesAvx2;
+#endif
+		return stagesScalar;
+	}
+	
+	static void stages(u32 *f, int n) {
+		static void (*const kernel)(u32 *, int) = chooseStages();
+		kernel(f, n);
+	}
+	
+	// 长度为 len 的一段做完整的正变换：位逆序置换后逐层蝶形
+	static void transformRow(u32 *f, int len, const vector<int> &rev) {
+		for (int i = 0; i < len; i++) {
+			if (i < rev[i]) swap(f[i], f[rev[i]]);
+		}
+		stages(f, len);
+	}
+	
+	// ---------- 四步法（Bailey）：n >= FOUR_STEP_MIN 时使用 ----------
+	// 长度超过 L2 后，逐层蝶形每一层都要把整个数组读写一遍。四步法把数组看成 n2 行 × n1 列的矩阵
+	// （x[j2·n1 + j1]，n1 = 2^{floor(log n / 2)}），记 k = k2 + n2·k1，则
+	//   X[k2 + n2·k1] = Σ_{j1} ω_{n1}^{j1·k1} · ω_n^{j1·k2} · Σ_{j2} x[j2·n1 + j1] · ω_{n2}^{j2·k2}，
+	// 依次为：沿列做长度 n2 的变换、乘旋转因子 ω_n^{j1·k2}、沿行做长度 n1 的变换。
+	// 列变换每次取相邻 COLS 列（一个缓存行），把这一条 n2 × COLS 的子矩阵拷到连续缓冲区中
+	// 做完全部各层，拷入或写回时顺带乘上旋转因子；行是连续的，每行同样在缓存中做完。整个数组只被完整读写约两遍，
+	// 不需要转置。列块和行都分给多个线程。
+	// 结果 X[k2 + n2·k1] 存放在 k2·n1 + k1，即转置顺序；逆序的过程（先行、再旋转因子、再列）
+	// 从转置顺序出发得到自然顺序的变换结果。卷积只做逐点乘法，直接在转置顺序下进行，
+	// transform() 需要自然顺序时再补一次分块转置。
+	static const int FOUR_STEP_MIN = 1 << 20;
+	static const int COLS = 16;
+	
+	static void splitSize(int n, int &n1, int &n2) {
+		int logn = __builtin_ctz(n);
+		n1 = 1 << (logn / 2);
+		n2 = n / n1;
+	}
+	
+	// 旋转因子矩阵：tw[k2·n1 + j1] = ω_n^{j1·k2}（Montgomery 形式），与数据同样布局，
+	// 列块处理时按同样的位置读取。按 log2(n) 缓存
+	static const vector<u32> &twiddleMatrix(int n) {
+		static vector<vector<u32>> tables;
+		int logn = __builtin_ctz(n);
+		if ((int)tables.size() <= logn) tables.resize(logn + 1);
+		vector<u32> &tw = tables[logn];
+		if (tw.empty()) {
+			int n1, n2;
+			splitSize(n, n1, n2);
+			tw.resize(n);
+			u32 step = toMont(modexp(G, (P - 1) / n, P));
+			u32 base = toMont(1);
+			for (int k2 = 0; k2 < n2; k2++) {
+				u32 *row = tw.data() + (size_t)k2 * n1;
+				row[0] = toMont(1);
+				for (int j1 = 1; j1 < n1; j1++) row[j1] = mul(row[j1 - 1], base);
+				base = mul(base, step);
+			}
 		}
-		for (int i = 0; i < n; i += 2 * len) {
-			ll w = 1;
-			for (int j = 0; j < len; j++) {
-				ll u = a[i + j];
-				ll v = (a[i + j + len] * w) % MOD;
-				a[i + j] = u + v < MOD ? u + v : u + v - MOD;
-				a[i + j + len] = u - v >= 0 ? u - v : u - v + MOD;
-				w = (w * wlen) % MOD;
+		return tw;
+	}
+	
+	// 列块上的逐层蝶形：f 指向块的左上角，rows 行、行距 stride，每行取 COLS 个相邻元素。
+	// 同一对行共用一个旋转因子，对 COLS 列同时做，与 stageRangeScalar 的运算相同
+	static void columnStagesScalar(u32 *f, int rows, int stride) {
+		for (int len = 1; len < rows; len *= 2) {
+			const u32 *w = roots().data() + len;
+			for (int i = 0; i < rows; i += 2 * len) {
+				for (int j = 0; j < len; j++) {
+					u32 *x = f + (size_t)(i + j) * stride;
+					u32 *y = x + (size_t)len * stride;
+					for (int c = 0; c < COLS; c++) {
+						u32 u = x[c];
+						u32 v = reduce((u64)y[c] * w[j]);
+						x[c] = shrink2(u + v);
+						y[c] = shrink2(u + P2 - v);
+					}
+				}
 			}
 		}
-		len = len * 2;
 	}
 	
-	if (invert) {
-		ll inv_n = modexp(n, MOD - 2);
+#ifdef NTT_HAS_AVX2_KERNEL
+	// AVX2 版本：每行的 COLS = 16 列正好是两个 __m256i，旋转因子广播到 8 个通道
+	__attribute__((target("avx2")))
+	static void columnStagesAvx2(u32 *f, int rows, int stride) {
+		const __m256i ninv = _mm256_set1_epi32(NINV);
+		const __m256i mod = _mm256_set1_epi32(P);
+		const __m256i mod2 = _mm256_set1_epi32(P2);
+		for (int len = 1; len < rows; len *= 2) {
+			const u32 *w = roots().data() + len;
+			for (int i = 0; i < rows; i += 2 * len) {
+				for (int j = 0; j < len; j++) {
+					u32 *x = f + (size_t)(i + j) * stride;
+					u32 *y = x + (size_t)len * stride;
+					__m256i wj = _mm256_set1_epi32(w[j]);
+					for (int c = 0; c < COLS; c += 8) {
+						__m256i u = _mm256_loadu_si256((const __m256i *)(x + c));
+						__m256i v = montMulAvx2(_mm256_loadu_si256((const __m256i *)(y + c)), wj, ninv, mod);
+						_mm256_storeu_si256((__m256i *)(x + c), shrinkAvx2(_mm256_add_epi32(u, v), mod2));
+						_mm256_storeu_si256((__m256i *)(y + c), shrinkAvx2(_mm256_sub_epi32(_mm256_add_epi32(u, mod2), v), mod2));
+					}
+				}
+			}
+		}
+	}
+#endif
+	
+	static void (*chooseColumnStages())(u32 *, int, int) {
+#ifdef NTT_HAS_AVX2_KERNEL
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) return columnStagesAvx2;
+#endif
+		return columnStagesScalar;
+	}
+	
+	// 从 f 起的一个列块：twiddleFirst 为 false 时先做列变换再乘旋转因子（正向），
+	// 为 true 时先乘旋转因子再做列变换（逆序过程）。
+	// 行距 stride 为 2 的幂，直接在原处按列做蝶形时各行落在同一组缓存行上互相驱逐，
+	// 所以先把这 rows × COLS 的子矩阵按位逆序的行顺序拷到连续的缓冲区，做完再写回
+	static void transformColumnBlock(u32 *f, const u32 *tw, int rows, int stride,
+	                                 const vector<int> &rev, bool twiddleFirst) {
+		static void (*const columnStages)(u32 *, int, int) = chooseColumnStages();
+		static thread_local vector<u32> block;
+		block.resize((size_t)rows * COLS);
+		u32 *b = block.data();
+		for (int r = 0; r < rows; r++) {
+			const u32 *x = f + (size_t)rev[r] * stride;
+			u32 *y = b + (size_t)r * COLS;
+			if (twiddleFirst) {
+				const u32 *t = tw + (size_t)rev[r] * stride;
+				for (int c = 0; c < COLS; c++) y[c] = reduce((u64)x[c] * t[c]);
+			} else {
+				copy(x, x + COLS, y);
+			}
+		}
+		columnStages(b, rows, COLS);
+		for (int r = 0; r < rows; r++) {
+			u32 *x = f + (size_t)r * stride;
+			const u32 *y = b + (size_t)r * COLS;
+			if (twiddleFirst) {
+				copy(y, y + COLS, x);
+			} else {
+				const u32 *t = tw + (size_t)r * stride;
+				for (int c = 0; c < COLS; c++) x[c] = reduce((u64)y[c] * t[c]);
+			}
+		}
+	}
+	
+	// 四步法变换。forward 为 true 时输入自然顺序、输出转置顺序；为 false 时输入转置顺序、输出自然顺序
+	static void fourStep(u32 *a, int n, bool forward) {
+		int n1, n2;
+		splitSize(n, n1, n2);
+		const vector<int> &rev1 = bitReverse(n1);
+		const vector<int> &rev2 = bitReverse(n2);
+		const u32 *tw = twiddleMatrix(n).data();
+		
+		auto columns = [=, &rev2](int lo, int hi) {
+			for (int b = lo; b < hi; b++) transformColumnBlock(a + b * COLS, tw + b * COLS, n2, n1, rev2, !forward);
+		};
+		auto rows = [=, &rev1](int lo, int hi) {
+			for (int r = lo; r < hi; r++) transformRow(a + (size_t)r * n1, n1, rev1);
+		};
+		if (forward) {
+			parallelFor(n1 / COLS, columns);
+			parallelFor(n2, rows);
+		} else {
+			parallelFor(n2, rows);
+			parallelFor(n1 / COLS, columns);
+		}
+	}
+	
+	// 不分组的整段变换（n < FOUR_STEP_MIN）。n >= PARALLEL_MIN 且线程池不止一个线程时：
+	// 位逆序按下标分段并行（每对交换只由较小下标所在的段执行）；前 log(n / segs) 层只在
+	// 长为 n / segs 的段内进行，各段交给不同线程；之后的每一层把 n/2 个蝶形按编号等分。
+	// 每个蝶形的运算与单线程时完全相同，结果逐位一致。
+	static const int PARALLEL_MIN = 1 << 16;
+	
+	static void transformWhole(u32 *f, int n) {
+		const vector<int> &rev = bitReverse(n);
+		int threads = pool.size();
+		if (threads <= 1 || n < PARALLEL_MIN) {
+			transformRow(f, n, rev);
+			return;
+		}
+		parallelFor(n, [=, &rev](int lo, int hi) {
+			for (int i = lo; i < hi; i++) {
+				if (i < rev[i]) swap(f[i], f[rev[i]]);
+			}
+		});
+		int segs = 1;
+		while (segs < threads && segs < n / 16) segs *= 2;
+		int seg = n / segs, part = n / 2 / segs;
+		parallelFor(segs, [=](int lo, int hi) {
+			for (int k = lo; k < hi; k++) stages(f + (size_t)k * seg, seg);
+		});
+		for (int len = seg; len < n; len *= 2) {
+			parallelFor(segs, [=](int lo, int hi) { stageRange(f, len, lo * part, hi * part); });
+		}
+	}
+	
+	// 生成长度 n 的变换需要的全部缓存表。表生成后只读，
+	// 在多个线程中同时变换前先在当前线程调用一次，避免并发写入共用的缓存
+	static void prepare(int n) {
+		if (n < FOUR_STEP_MIN) {
+			prepareRoots(n);
+			bitReverse(n);
+			return;
+		}
+		int n1, n2;
+		splitSize(n, n1, n2);
+		prepareRoots(max(n1, n2));
+		bitReverse(n1);
+		bitReverse(n2);
+		twiddleMatrix(n);
+	}
+	
+	// 只用于逐点运算的变换：长度达到 FOUR_STEP_MIN 时正变换的结果为转置顺序，
+	// 逆变换也从转置顺序出发，省去转置；更短时与 transform() 相同。
+	// 逆变换利用 INTT(a)[k] = NTT(a)[(n - k) mod n] / n，与正变换共用同一张单位根表；
+	// 除以 n 留给调用方，通常并入 fromMont。
+	static void transformUnordered(u32 *f, int n, bool invert) {
+		if (n == 1) return;
+		
+		prepare(n);
+		if (n >= FOUR_STEP_MIN) fourStep(f, n, !invert);
+		else transformWhole(f, n);
+		
+		if (invert) reverse(f + 1, f + n);
+	}
+	
+	static void transformUnordered(vector<u32> &f, bool invert) {
+		transformUnordered(f.data(), f.size(), invert);
+	}
+	
+	// 原地 NTT，n 须为 2 的幂，输入输出均为自然顺序；长度达到 FOUR_STEP_MIN 时自动改用四步法，
+	// 并用一次分块转置在转置顺序与自然顺序之间转换
+	static void transform(vector<u32> &f, bool invert) {
+		int n = f.size();
+		if (n < FOUR_STEP_MIN) {
+			transformUnordered(f, invert);
+			return;
+		}
+		int n1, n2;
+		splitSize(n, n1, n2);
+		// 转置用的缓冲区每个线程一份，同一模数的变换可以在多个线程中同时进行
+		static thread_local vector<u32> scratch;
+		scratch.resize(n);
+		if (invert) {
+			transposeBlocked(f.data(), scratch.data(), n1, n2);
+			f.swap(scratch);
+			transformUnordered(f, true);
+		} else {
+			transformUnordered(f, false);
+			transposeBlocked(f.data(), scratch.data(), n2, n1);
+			f.swap(scratch);
+		}
+	}
+	
+	// A 的前 szA 项与 B 的前 szB 项做长度为 n 的循环卷积（szA、szB <= n），返回第 [lo, hi) 项，
+	// 为 [0, P) 内的普通形式；超出 n 的项卷回低位。全程保持 Montgomery 形式：
+	// 系数转入一次、点乘、逆变换后转出一次，转出时 fromMont(f, n^{-1}) 同时完成除以 R 和除以 n
+	static vector<u32> convolve(const vector<int> &A, int szA, const vector<int> &B, int szB, int n, int lo, int hi) {
+		vector<u32> fa(n, 0), fb(n, 0);
+		for (int i = 0; i < szA; i++) fa[i] = toMont(A[i]);
+		for (int j = 0; j < szB; j++) fb[j] = toMont(B[j]);
+		
+		// 两个正变换互相独立，同时进行
+		prepare(n);
+		parallelFor(2, [&](int lo, int hi) {
+			for (int k = lo; k < hi; k++) transformUnordered(k == 0 ? fa : fb, false);
+		});
 		for (int i = 0; i < n; i++) {
-			a[i] = (a[i] * inv_n) % MOD;
+			fa[i] = reduce((u64)fa[i] * fb[i]);
 		}
+		transformUnordered(fa, true);
+		
+		u32 inv_n = modexp(n, P - 2, P);
+		vector<u32> C(hi - lo);
+		for (int i = lo; i < hi; i++) C[i - lo] = fromMont(fa[i], inv_n);
+		return C;
+	}
+	
+	// 模 P 的完整乘积
+	static vector<u32> convolve(const vector<int> &A, const vector<int> &B) {
+		int len = A.size() + B.size() - 1;
+		int n = 1;
+		while (n < len) n = n * 2;
+		return convolve(A, A.size(), B, B.size(), n, 0, len);
 	}
+};
+
+using Ntt = MontNtt<MOD, PRIMITIVE_ROOT>;
+
+// 普通形式的接口：转入 Montgomery 形式做变换再转回，逆变换在转回时乘上 n^{-1}
+void ntt(vector<ll> &a, bool invert) {
+	int n = a.size();
+	vector<u32> f(n);
+	for (int i = 0; i < n; i++) f[i] = Ntt::toMont(a[i]);
+	Ntt::transform(f, invert);
+	u32 scale = invert ? modexp(n, MOD - 2) : 1;
+	for (int i = 0; i < n; i++) a[i] = Ntt::fromMont(f[i], scale);
 }
 
 
 vector<ll> multiply(const vector<int> &A, const vector<int> &B) {
-	int szA = A.size();
-	int szB = B.size();
+	vector<u32> C = Ntt::convolve(A, B);
+	return vector<ll>(C.begin(), C.end());
+}
+
+// 乘积的前 k 项：两边只需前 k 项参与，变换长度按截断后的乘积长度选取
+vector<ll> multiplyTruncated(const vector<int> &A, const vector<int> &B, int k) {
+	int na = min((int)A.size(), k), nb = min((int)B.size(), k);
+	if (na == 0 || nb == 0) return vector<ll>(max(k, 0), 0);
+	int n = 1;
+	while (n < na + nb - 1) n = n * 2;
+	vector<u32> C = Ntt::convolve(A, na, B, nb, n, 0, min(na + nb - 1, k));
+	vector<ll> res(C.begin(), C.end());
+	res.resize(k, 0);
+	return res;
+}
+
+// 中间积：|A| >= |B| = m 时返回乘积的第 m-1 到 |A|-1 项，共 |A| - m + 1 项，
+// 即 B 反转后在 A 上滑动的各个完整窗口的相关值。乘积最高到第 |A|+m-2 项，
+// 取长度 n >= |A| 的循环卷积时超出的项卷回 [0, m-2]，不影响所需各项，变换长度约为完整乘积的一半
+vector<ll> multiplyMiddle(const vector<int> &A, const vector<int> &B) {
+	int na = A.size(), m = B.size();
+	if (m == 0 || na < m) return {};
 	int n = 1;
-	while (n < szA + szB - 1) n = n * 2;
+	while (n < na) n = n * 2;
+	vector<u32> C = Ntt::convolve(A, na, B, m, n, m - 1, na);
+	return vector<ll>(C.begin(), C.end());
+}
+
+// ---------- 三模数 NTT + Garner 重建 ----------
+// 三个素数的乘积 M = P1·P2·P3 约为 5.9e25（约 2^85），卷积每一项的真值 x 只要满足 |x| < M/2，
+// 就能由它模 P1、P2、P3 的余数唯一确定。Garner 算法把 x mod M 写成
+//   x = r1 + k1·P1 + k2·P1·P2，k1 = (r2 - r1)·P1^{-1} mod P2，k2 = (r3 - r1 - k1·P1)·(P1·P2)^{-1} mod P3，
+// 各步只需 64 位乘法。
+const u32 CRT_P1 = 167772161;   // 2^25·5 + 1
+const u32 CRT_P2 = 469762049;   // 2^26·7 + 1
+const u32 CRT_P3 = 754974721;   // 2^24·45 + 1
+using NttP1 = MontNtt<CRT_P1, 3>;
+using NttP2 = MontNtt<CRT_P2, 3>;
+using NttP3 = MontNtt<CRT_P3, 11>;
+
+// 三个模数下各做一次卷积，交给线程池同时进行。
+// 位逆序表是三者共用的缓存，各模数的表先在当前线程中生成，之后各线程只读。
+void convolveThreePrimes(const vector<int> &A, const vector<int> &B,
+                         vector<u32> &r1, vector<u32> &r2, vector<u32> &r3) {
+	int n = 1;
+	while (n < (int)A.size() + (int)B.size() - 1) n = n * 2;
+	NttP1::prepare(n);
+	NttP2::prepare(n);
+	NttP3::prepare(n);
 	
-	vector<ll> fa(n, 0), fb(n, 0);
-	for (int i = 0; i < szA; i++) fa[i] = A[i];
-	for (int j = 0; j < szB; j++) fb[j] = B[j];
+	parallelFor(3, [&](int lo, int hi) {
+		for (int k = lo; k < hi; k++) {
+			if (k == 0) r1 = NttP1::convolve(A, B);
+			else if (k == 1) r2 = NttP2::convolve(A, B);
+			else r3 = NttP3::convolve(A, B);
+		}
+	});
+}
+
+// Garner 重建：返回 (k1, k2)，使 x mod M = r1 + k1·P1 + k2·P1·P2
+inline pair<ll, ll> garner(u32 r1, u32 r2, u32 r3) {
+	static const ll INV_P1 = modexp(CRT_P1, CRT_P2 - 2, CRT_P2);
+	static const ll INV_P1P2 = modexp((ll)CRT_P1 * CRT_P2 % CRT_P3, CRT_P3 - 2, CRT_P3);
+	ll k1 = ((ll)r2 - r1 + CRT_P2) % CRT_P2 * INV_P1 % CRT_P2;
+	ll k2 = (((ll)r3 - r1 - k1 * CRT_P1 % CRT_P3) % CRT_P3 + 2 * (ll)CRT_P3) % CRT_P3 * INV_P1P2 % CRT_P3;
+	return {k1, k2};
+}
+
+// 任意模数下的乘积（1 <= mod < 2^31）。系数先化到 [0, mod)，卷积各项不超过 L·mod^2 < M，
+// 由三个余数精确重建后再取模（L 为较短序列的长度，mod 接近 2^31 时 L 可达约 10^7）
+vector<ll> multiplyMod(const vector<int> &A, const vector<int> &B, int mod) {
+	auto reduceInput = [&](const vector<int> &v) {
+		vector<int> r(v.size());
+		for (size_t i = 0; i < v.size(); i++) r[i] = ((ll)v[i] % mod + mod) % mod;
+		return r;
+	};
+	vector<u32> r1, r2, r3;
+	convolveThreePrimes(reduceInput(A), reduceInput(B), r1, r2, r3);
 	
-	ntt(fa, false);
-	ntt(fb, false);
-	for (int i = 0; i < n; i++) {
-		fa[i] = (fa[i] * fb[i]) % MOD;
+	ll p1 = CRT_P1 % mod;
+	ll p1p2 = (ll)CRT_P1 * CRT_P2 % mod;
+	vector<ll> C(r1.size());
+	for (size_t i = 0; i < C.size(); i++) {
+		auto [k1, k2] = garner(r1[i], r2[i], r3[i]);
+		C[i] = (r1[i] % mod + k1 % mod * p1 % mod + k2 % mod * p1p2 % mod) % mod;
 	}
-	ntt(fa, true);
+	return C;
+}
+
+// 精确乘积，结果为 128 位有符号整数。系数可为负，要求卷积各项的真值 |x| < M/2（约 2^84），
+// 例如 |系数| < 2^31 时序列长度可到约 6·10^6；重建出的 x mod M 大于 M/2 时减去 M 还原负数
+vector<__int128> multiplyExact(const vector<int> &A, const vector<int> &B) {
+	vector<u32> r1, r2, r3;
+	convolveThreePrimes(A, B, r1, r2, r3);
 	
-	fa.resize(szA + szB - 1);
-	return fa;
+	const __int128 p1p2 = (__int128)CRT_P1 * CRT_P2;
+	const __int128 M = p1p2 * CRT_P3;
+	vector<__int128> C(r1.size());
+	for (size_t i = 0; i < C.size(); i++) {
+		auto [k1, k2] = garner(r1[i], r2[i], r3[i]);
+		__int128 x = r1[i] + (__int128)k1 * CRT_P1 + k2 * p1p2;
+		C[i] = x > M / 2 ? x - M : x;
+	}
+	return C;
+}
+
+// __int128 没有流输出运算符，转成十进制字符串
+string toString(__int128 x) {
+	if (x == 0) return "0";
+	bool neg = x < 0;
+	string s;
+	while (x != 0) {
+		int d = (int)(x % 10);
+		s += char('0' + (neg ? -d : d));
+		x /= 10;
+	}
+	if (neg) s += '-';
+	reverse(s.begin(), s.end());
+	return s;
 }
 
-int main() {
+// ---------- 多项式工具（模 998244353） ----------
+// 求逆、开方、ln、exp 用牛顿迭代，带余除法用反转多项式求逆，均为 O(n log n)；
+// 多点求值与插值基于子积树，为 O(n log^2 n)。
+// 内部系数一律是 [0, P) 内的 Montgomery 形式，只在对外接口处转换；变换只用于逐点乘法，
+// 直接使用 transformUnordered。牛顿迭代用到的缓冲区与单位根表在进入循环前一次准备到最终长度
+// （缓冲区每个线程一份），循环内只使用其前缀，不再分配内存。
+struct PolyKit {
+	using N = Ntt;
+	static constexpr u32 P = MOD;
+	static const int NAIVE = 32;    // 较短一方不超过该长度时直接做朴素乘法
+	
+	static u32 one() { return N::toMont(1); }
+	static u32 add(u32 a, u32 b) { return N::shrink(a + b); }
+	static u32 sub(u32 a, u32 b) { return a >= b ? a - b : a + P - b; }
+	static u32 neg(u32 a) { return a ? P - a : 0; }
+	static u32 inverse(u32 a) { return N::toMont(modexp(N::fromMont(a), P - 2)); }
+	
+	static u32 *buffer(vector<u32> &v, size_t n) {
+		if (v.size() < n) v.resize(n);
+		return v.data();
+	}
+	
+	// 长度不超过 n 的各次变换所需的表
+	static void prepareUpTo(int n) {
+		for (int k = 1; k <= n; k *= 2) N::prepare(k);
+	}
+	
+	// inverses(n)[i] = 1 / i（1 <= i < n），线性递推 1/i = -(P / i) · 1/(P mod i)
+	static const u32 *inverses(int n) {
+		static thread_local vector<u32> plain{0, 1}, mont{0, N::toMont(1)};
+		for (int i = plain.size(); i < n; i++) {
+			plain.push_back((u64)(P - P / i) * plain[P % i] % P);
+			mont.push_back(N::toMont(plain[i]));
+		}
+		return mont.data();
+	}
+	
+	static void dft(u32 *f, int n) { N::transformUnordered(f, n, false); }
+	// 逆变换，只对之后用到的 [lo, hi) 乘上 n^{-1}，结果在 [0, P)
+	static void idft(u32 *f, int n, int lo, int hi) {
+		N::transformUnordered(f, n, true);
+		u32 scale = N::toMont(modexp(n, P - 2));
+		for (int i = lo; i < hi; i++) f[i] = N::mul(f[i], scale);
+	}
+	static void dot(u32 *a, const u32 *b, int n) {
+		for (int i = 0; i < n; i++) a[i] = N::reduce((u64)a[i] * b[i]);
+	}
+	
+	// 乘积的前 limit 项（默认为完整乘积）；只有两边的前 limit 项参与，变换长度随之缩短
+	static vector<u32> multiply(const vector<u32> &a, const vector<u32> &b, int limit = INT_MAX) {
+		int na = min((int)a.size(), limit), nb = min((int)b.size(), limit);
+		if (na == 0 || nb == 0) return {};
+		int full = na + nb - 1, len = min(full, limit);
+		vector<u32> c(len, 0);
+		if (min(na, nb) <= NAIVE) {
+			for (int i = 0; i < na; i++) {
+				for (int j = 0; j < nb && i + j < len; j++) c[i + j] = add(c[i + j], N::mul(a[i], b[j]));
+			}
+			return c;
+		}
+		int n = 1;
+		while (n < full) n = n * 2;
+		vector<u32> fa(n, 0), fb(n, 0);
+		copy(a.begin(), a.begin() + na, fa.begin());
+		copy(b.begin(), b.begin() + nb, fb.begin());
+		N::prepare(n);
+		parallelFor(2, [&](int lo, int hi) {
+			for (int k = lo; k < hi; k++) dft(k == 0 ? fa.data() : fb.data(), n);
+		});
+		dot(fa.data(), fb.data(), n);
+		idft(fa.data(), n, 0, len);
+		copy(fa.begin(), fa.begin() + len, c.begin());
+		return c;
+	}
+	
+	// 牛顿迭代求逆的一步：fk 为 f mod x^k 的长度 k 变换，t 的前 k/2 项为 f^{-1} mod x^{k/2}，
+	// 按 t ← t·(2 - f·t) 补出 t[k/2, k)。f·t ≡ 1 (mod x^{k/2})，长度 k 的循环卷积只把溢出的项
+	// 卷回低半段，高半段 [k/2, k) 仍是准确的；再乘一次 t 时同理。T、Z 为长度 k 的缓冲区
+	static void extendInverse(const u32 *fk, u32 *t, int k, u32 *T, u32 *Z) {
+		int h = k / 2;
+		copy(t, t + h, T);
+		fill(T + h, T + k, 0);
+		dft(T, k);
+		for (int i = 0; i < k; i++) Z[i] = N::reduce((u64)fk[i] * T[i]);
+		idft(Z, k, h, k);
+		fill(Z, Z + h, 0);
+		dft(Z, k);
+		dot(Z, T, k);
+		idft(Z, k, h, k);
+		for (int i = h; i < k; i++) t[i] = neg(Z[i]);
+	}
+	
+	// g[0, n) = f^{-1} mod x^n，要求 f[0] != 0；f 只用前 min(nf, n) 项
+	static void inverseInto(const u32 *f, int nf, u32 *g, int n) {
+		int cap = 1;
+		while (cap < n) cap = cap * 2;
+		static thread_local vector<u32> bufF, bufG, bufT, bufZ;
+		u32 *F = buffer(bufF, cap), *G = buffer(bufG, cap);
+		u32 *T = buffer(bufT, cap), *Z = buffer(bufZ, cap);
+		prepareUpTo(cap);
+		
+		G[0] = inverse(f[0]);
+		for (int k = 2; k <= cap; k *= 2) {
+			int m = min(nf, k);
+			copy(f, f + m, F);
+			fill(F + m, F + k, 0);
+			dft(F, k);
+			extendInverse(F, G, k, T, Z);
+		}
+		copy(G, G + n, g);
+	}
+	
+	// 带余除法 a = b·q + r，要求 b 的最高项非零，deg r < deg b。
+	// q 由反转多项式求得：rev(q) = rev(a)·rev(b)^{-1} mod x^{|a|-|b|+1}。
+	// r 只有低 |b|-1 项，取长度 L >= |b|-1 的循环卷积：b·q ≡ a - r (mod x^L - 1)，
+	// 因此 r 等于 a 折叠到长度 L 后减去 b、q 的循环卷积，不必算出完整乘积
+	static void divMod(const vector<u32> &a, const vector<u32> &b, vector<u32> &q, vector<u32> &r) {
+		int na = a.size(), nb = b.size();
+		if (na < nb) {
+			q.clear();
+			r = a;
+			return;
+		}
+		int nq = na - nb + 1;
+		vector<u32> ra(a.rbegin(), a.rbegin() + nq), rb(b.rbegin(), b.rend());
+		vector<u32> inv(nq);
+		inverseInto(rb.data(), nb, inv.data(), nq);
+		q = multiply(ra, inv, nq);
+		reverse(q.begin(), q.end());
+		
+		r.assign(nb - 1, 0);
+		if (nb == 1) return;
+		int L = 1;
+		while (L < nb - 1) L = L * 2;
+		vector<u32> fa(L, 0), fb(L, 0), fq(L, 0);
+		for (int i = 0; i < na; i++) fa[i & (L - 1)] = add(fa[i & (L - 1)], a[i]);
+		for (int i = 0; i < nb; i++) fb[i & (L - 1)] = add(fb[i & (L - 1)], b[i]);
+		for (int i = 0; i < nq; i++) fq[i & (L - 1)] = add(fq[i & (L - 1)], q[i]);
+		dft(fb.data(), L);
+		dft(fq.data(), L);
+		dot(fb.data(), fq.data(), L);
+		idft(fb.data(), L, 0, nb - 1);
+		for (int i = 0; i < nb - 1; i++) r[i] = sub(fa[i], fb[i]);
+	}
+	
+	// g[0, n) = ln f mod x^n = ∫ f'/f，要求 f[0] = 1
+	static void logInto(const u32 *f, int nf, u32 *g, int n) {
+		g[0] = 0;
+		if (n == 1) return;
+		vector<u32> inv(n - 1), d(n - 1, 0);
+		inverseInto(f, nf, inv.data(), n - 1);
+		for (int i = 0; i < n - 1 && i + 1 < nf; i++) d[i] = N::mul(f[i + 1], N::toMont(i + 1));
+		vector<u32> h = multiply(d, inv, n - 1);
+		const u32 *invs = inverses(n);
+		for (int i = 1; i < n; i++) g[i] = N::mul(h[i - 1], invs[i]);
+	}
+	
+	// g[0, n) = exp f mod x^n，要求 f[0] = 0。
+	// 牛顿迭代 b ← b·(1 + f - ln b)，同时维护 c = b^{-1}：第 m 轮已知 b mod x^m、c mod x^{m/2}，
+	// 先用 extendInverse 把 c 补到 mod x^m。因为 ln b ≡ f (mod x^m)，
+	// W = b·(f' mod x^{m-1}) - b' 被 x^{m-1} 整除且次数不超过 2m-3，长度 m 的循环卷积
+	// 恰好把它的 [m, 2m-2] 各项折叠到 [0, m-2]，移回原位即得 W；
+	// 于是 f - ln b 在 [m, 2m) 上等于 ∫(W·c) 加上 f 的对应项，只需 c mod x^m
+	static void expInto(const u32 *f, int nf, u32 *g, int n) {
+		auto at = [&](int i) { return i < nf ? f[i] : 0u; };
+		g[0] = one();
+		if (n == 1) return;
+		int cap = 1;
+		while (cap < n) cap = cap * 2;
+		static thread_local vector<u32> bufB, bufC, bufY, bufYm, bufZ2, bufX, bufT, bufZ;
+		u32 *B = buffer(bufB, cap), *C = buffer(bufC, cap);
+		u32 *Y = buffer(bufY, cap), *Ym = buffer(bufYm, cap), *Z2 = buffer(bufZ2, cap);
+		u32 *X = buffer(bufX, cap), *T = buffer(bufT, cap), *Z = buffer(bufZ, cap);
+		prepareUpTo(cap);
+		const u32 *invs = inverses(cap);
+		
+		B[0] = one();
+		B[1] = at(1);
+		C[0] = one();
+		for (int m = 2; m < n; m *= 2) {
+			copy(B, B + m, Ym);
+			dft(Ym, m);
+			copy(B, B + m, Y);
+			fill(Y + m, Y + 2 * m, 0);
+			dft(Y, 2 * m);
+			extendInverse(Ym, C, m, T, Z);
+			copy(C, C + m, Z2);
+			fill(Z2 + m, Z2 + 2 * m, 0);
+			dft(Z2, 2 * m);
+			
+			// W = b·f' - b'
+			for (int i = 0; i < m - 1; i++) X[i] = N::mul(at(i + 1), N::toMont(i + 1));
+			X[m - 1] = 0;
+			dft(X, m);
+			dot(X, Ym, m);
+			idft(X, m, 0, m);
+			for (int i = 0; i < m - 1; i++) {
+				X[m + i] = sub(X[i], N::mul(B[i + 1], N::toMont(i + 1)));
+				X[i] = 0;
+			}
+			X[2 * m - 1] = 0;
+			
+			// f - ln b 的 [m, 2m) 项，低 m 项为 0
+			dft(X, 2 * m);
+			dot(X, Z2, 2 * m);
+			idft(X, 2 * m, m - 1, 2 * m - 1);
+			for (int i = 2 * m - 1; i >= m; i--) X[i] = add(N::mul(X[i - 1], invs[i]), at(i));
+			fill(X, X + m, 0);
+			
+			// b 的 [m, 2m) 项为 b·(f - ln b) 的对应项
+			dft(X, 2 * m);
+			dot(X, Y, 2 * m);
+			idft(X, 2 * m, m, 2 * m);
+			copy(X + m, X + 2 * m, B + m);
+		}
+		copy(B, B + n, g);
+	}
+	
+	// 模 P 的平方根（Tonelli–Shanks），普通形式；a 不是二次剩余时返回 -1，否则返回两个根中较小的一个
+	static ll sqrtMod(ll a) {
+		if (a == 0) return 0;
+		if (modexp(a, (P - 1) / 2) != 1) return -1;
+		int s = __builtin_ctz(P - 1);
+		ll z = 2;
+		while (modexp(z, (P - 1) / 2) != P - 1) z++;
+		ll c = modexp(z, (P - 1) >> s);
+		ll t = modexp(a, (P - 1) >> s);
+		ll r = modexp(a, (((P - 1) >> s) + 1) / 2);
+		while (t != 1) {
+			int i = 0;
+			for (ll x = t; x != 1; x = x * x % P) i++;
+			ll b = c;
+			for (int j = 0; j < s - i - 1; j++) b = b * b % P;
+			s = i;
+			c = b * b % P;
+			t = t * c % P;
+			r = r * b % P;
+		}
+		return min(r, P - r);
+	}
+	
+	// g[0, n) = sqrt(f) mod x^n，要求 f[0] 非零且为二次剩余。
+	// 牛顿迭代 s ← s + (f - s^2)/(2s)，同时维护 t = s^{-1}：第 k 轮已知 s mod x^k、t mod x^{k/2}。
+	// s^2 ≡ f (mod x^k)，所以 s^2 的高半段可由长度 k 的循环卷积减去 f 的低 k 项得到；
+	// s 的这次变换同时供 extendInverse 把 t 补到 mod x^k
+	static void sqrtInto(const u32 *f, int nf, u32 *g, int n) {
+		auto at = [&](int i) { return i < nf ? f[i] : 0u; };
+		int cap = 1;
+		while (cap < n) cap = cap * 2;
+		static thread_local vector<u32> bufS, bufT, bufSk, bufTk, bufZ, bufD, bufT2;
+		u32 *S = buffer(bufS, cap), *Tn = buffer(bufT, cap), *Sk = buffer(bufSk, cap);
+		u32 *Tk = buffer(bufTk, cap), *Z = buffer(bufZ, cap), *D = buffer(bufD, cap), *T2 = buffer(bufT2, cap);
+		prepareUpTo(cap);
+		const u32 inv2 = N::toMont((P + 1) / 2);
+		
+		S[0] = N::toMont(sqrtMod(N::fromMont(f[0])));
+		Tn[0] = inverse(S[0]);
+		for (int k = 1; k < n; k *= 2) {
+			copy(S, S + k, Sk);
+			dft(Sk, k);
+			if (k > 1) extendInverse(Sk, Tn, k, Tk, Z);
+			
+			// D = (f - s^2) / x^k mod x^k
+			for (int i = 0; i < k; i++) Z[i] = N::reduce((u64)Sk[i] * Sk[i]);
+			idft(Z, k, 0, k);
+			for (int i = 0; i < k; i++) D[i] = sub(add(at(k + i), at(i)), Z[i]);
+			
+			// s[k, 2k) = D·t / 2 mod x^k
+			fill(D + k, D + 2 * k, 0);
+			copy(Tn, Tn + k, T2);
+			fill(T2 + k, T2 + 2 * k, 0);
+			dft(D, 2 * k);
+			dft(T2, 2 * k);
+			dot(D, T2, 2 * k);
+			idft(D, 2 * k, 0, k);
+			for (int i = 0; i < k; i++) S[k + i] = N::mul(D[i], inv2);
+		}
+		copy(S, S + n, g);
+	}
+	
+	// 子积树：tree[v] = ∏_{l <= i < r} (x - xs[i])，按线段树方式编号
+	static void buildTree(vector<vector<u32>> &tree, const vector<u32> &xs, int v, int l, int r) {
+		if (r - l == 1) {
+			tree[v] = {neg(xs[l]), one()};
+			return;
+		}
+		int mid = (l + r) / 2;
+		buildTree(tree, xs, 2 * v, l, mid);
+		buildTree(tree, xs, 2 * v + 1, mid, r);
+		tree[v] = multiply(tree[2 * v], tree[2 * v + 1]);
+	}
+	
+	// f 已是对 tree[v] 取模后的余式；逐层取模到子区间，区间足够短时直接用秦九韶算法
+	static void evaluateDown(const vector<vector<u32>> &tree, const vector<u32> &f, const vector<u32> &xs,
+	                         int v, int l, int r, vector<u32> &ys) {
+		if (r - l <= NAIVE) {
+			for (int i = l; i < r; i++) {
+				u32 y = 0;
+				for (int j = (int)f.size() - 1; j >= 0; j--) y = add(N::mul(y, xs[i]), f[j]);
+				ys[i] = y;
+			}
+			return;
+		}
+		int mid = (l + r) / 2;
+		vector<u32> q, rem;
+		divMod(f, tree[2 * v], q, rem);
+		evaluateDown(tree, rem, xs, 2 * v, l, mid, ys);
+		divMod(f, tree[2 * v + 1], q, rem);
+		evaluateDown(tree, rem, xs, 2 * v + 1, mid, r, ys);
+	}
+	
+	static vector<u32> evaluate(const vector<vector<u32>> &tree, const vector<u32> &f, const vector<u32> &xs) {
+		int n = xs.size();
+		vector<u32> ys(n), q, rem;
+		divMod(f, tree[1], q, rem);
+		evaluateDown(tree, rem, xs, 1, 0, n, ys);
+		return ys;
+	}
+	
+	// 插值的合并：区间 [l, r) 上 Σ w_i · ∏_{j ≠ i} (x - x_j)
+	static vector<u32> combine(const vector<vector<u32>> &tree, const vector<u32> &w, int v, int l, int r) {
+		if (r - l == 1) return {w[l]};
+		int mid = (l + r) / 2;
+		vector<u32> left = multiply(combine(tree, w, 2 * v, l, mid), tree[2 * v + 1]);
+		vector<u32> right = multiply(combine(tree, w, 2 * v + 1, mid, r), tree[2 * v]);
+		for (size_t i = 0; i < right.size(); i++) left[i] = add(left[i], right[i]);
+		return left;
+	}
+	
+	static vector<u32> load(const vector<ll> &a) {
+		vector<u32> f(a.size());
+		for (size_t i = 0; i < a.size(); i++) f[i] = N::toMont(a[i]);
+		return f;
+	}
+	
+	static vector<ll> store(const u32 *f, int n) {
+		vector<ll> a(n);
+		for (int i = 0; i < n; i++) a[i] = N::fromMont(f[i]);
+		return a;
+	}
+};
+
+// 多项式工具的对外接口：系数按下标从低次到高次，可为任意整数（先对 MOD 取模），
+// 返回 [0, MOD) 内的系数。条件不满足时返回空向量
+
+// 1/a mod x^n，要求 a[0] 不是 MOD 的倍数
+vector<ll> polyInverse(const vector<ll> &a, int n) {
+	vector<u32> f = PolyKit::load(a);
+	if (n <= 0 || f.empty() || f[0] == 0) return {};
+	vector<u32> g(n);
+	PolyKit::inverseInto(f.data(), f.size(), g.data(), n);
+	return PolyKit::store(g.data(), n);
+}
+
+// 带余除法 a = b·q + r，返回 (q, r)。b 的高位零项先去掉，b 为零多项式时返回两个空向量；
+// q 的长度为 |a| - |b| + 1（|a| < |b| 时为空），r 的长度为 min(|a|, |b| - 1)
+pair<vector<ll>, vector<ll>> polyDivMod(const vector<ll> &a, const vector<ll> &b) {
+	vector<u32> fa = PolyKit::load(a), fb = PolyKit::load(b);
+	while (!fb.empty() && fb.back() == 0) fb.pop_back();
+	if (fb.empty()) return {};
+	vector<u32> q, r;
+	PolyKit::divMod(fa, fb, q, r);
+	return {PolyKit::store(q.data(), q.size()), PolyKit::store(r.data(), r.size())};
+}
+
+// ln a mod x^n，要求 a[0] ≡ 1
+vector<ll> polyLog(const vector<ll> &a, int n) {
+	vector<u32> f = PolyKit::load(a);
+	if (n <= 0 || f.empty() || f[0] != PolyKit::one()) return {};
+	vector<u32> g(n);
+	PolyKit::logInto(f.data(), f.size(), g.data(), n);
+	return PolyKit::store(g.data(), n);
+}
+
+// exp a mod x^n，要求 a[0] ≡ 0（a 为空视为 0）
+vector<ll> polyExp(const vector<ll> &a, int n) {
+	vector<u32> f = PolyKit::load(a);
+	if (n <= 0 || (!f.empty() && f[0] != 0)) return {};
+	vector<u32> g(n);
+	PolyKit::expInto(f.data(), f.size(), g.data(), n);
+	return PolyKit::store(g.data(), n);
+}
+
+// sqrt(a) mod x^n。最低非零项须为偶数次且系数为二次剩余，去掉 x 的偶数次幂后开方，
+// 常数项取两个平方根中较小的一个；a ≡ 0 时返回全 0
+vector<ll> polySqrt(const vector<ll> &a, int n) {
+	if (n <= 0) return {};
+	vector<u32> f = PolyKit::load(a);
+	int z = 0;
+	while (z < (int)f.size() && f[z] == 0) z++;
+	if (z == (int)f.size() || z / 2 >= n) return vector<ll>(n, 0);
+	if (z % 2 == 1 || PolyKit::sqrtMod(PolyKit::N::fromMont(f[z])) < 0) return {};
+	int shift = z / 2;
+	vector<u32> g(n, 0);
+	PolyKit::sqrtInto(f.data() + z, f.size() - z, g.data() + shift, n - shift);
+	return PolyKit::store(g.data(), n);
+}
+
+// 多点求值：返回 a(xs[0]), a(xs[1]), ...
+vector<ll> polyEvaluate(const vector<ll> &a, const vector<ll> &xs) {
+	if (xs.empty()) return {};
+	vector<u32> f = PolyKit::load(a), px = PolyKit::load(xs);
+	vector<vector<u32>> tree(4 * xs.size());
+	PolyKit::buildTree(tree, px, 1, 0, px.size());
+	vector<u32> ys = PolyKit::evaluate(tree, f, px);
+	return PolyKit::store(ys.data(), ys.size());
+}
+
+// 插值：返回次数小于 |xs| 且满足 p(xs[i]) = ys[i] 的多项式 p；xs 模 MOD 有重复时返回空向量。
+// 记 M(x) = ∏(x - xs[i])，则 p = Σ ys[i] / M'(xs[i]) · M(x) / (x - xs[i])
+vector<ll> polyInterpolate(const vector<ll> &xs, const vector<ll> &ys) {
+	int n = xs.size();
+	if (n == 0 || ys.size() != xs.size()) return {};
+	vector<u32> px = PolyKit::load(xs), py = PolyKit::load(ys);
+	vector<vector<u32>> tree(4 * n);
+	PolyKit::buildTree(tree, px, 1, 0, n);
+	vector<u32> d(n);
+	for (int i = 0; i < n; i++) d[i] = PolyKit::N::mul(tree[1][i + 1], PolyKit::N::toMont(i + 1));
+	vector<u32> w = PolyKit::evaluate(tree, d, px);
+	for (int i = 0; i < n; i++) {
+		if (w[i] == 0) return {};
+		w[i] = PolyKit::N::mul(py[i], PolyKit::inverse(w[i]));
+	}
+	vector<u32> p = PolyKit::combine(tree, w, 1, 0, n);
+	return PolyKit::store(p.data(), n);
+}
+
+// 用法：./NTT [--mod p | --exact] [--threads k]
+// 不带参数时输出模 998244353 的乘积；--mod p 输出模任意 p 的乘积（1 <= p < 2^31），
+// --exact 输出精确乘积，后两者走三模数 NTT。--threads 指定线程数，默认为 CPU 核数，
+// 1 即单线程；结果与线程数无关。编译需 g++ -pthread
+int main(int argc, char *argv[]) {
 	ios::sync_with_stdio(false);
 	cin.tie(nullptr);
 	
+	ll mod = 0;
+	int threads = 0;
+	bool exact = false, bad = false;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--exact") exact = true;
+		else if (arg == "--mod" && i + 1 < argc) {
+			mod = atoll(argv[++i]);
+			bad |= mod < 1 || mod >= (1LL << 31);
+		}
+		else if (arg == "--threads" && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+			bad |= threads < 1;
+		}
+		else bad = true;
+	}
+	if (bad || (exact && mod != 0)) {
+		cerr << "Usage: ./NTT [--mod p | --exact] [--threads k]  (1 <= p < 2^31)" << endl;
+		return 1;
+	}
+	pool.resize(threads > 0 ? threads : max(1u, thread::hardware_concurrency()));
+	
 	int n, m;
 	cin >> n >> m;
 	vector<int> F(n + 1), G(m + 1);
@@ -100,7 +1238,16 @@ int main() {
 	reverse(F.begin(), F.end());
 	reverse(G.begin(), G.end());
 	
-	vector<ll> H = multiply(F, G);
+	if (exact) {
+		vector<__int128> H = multiplyExact(F, G);
+		for (int idx = (int)H.size() - 1; idx >= 0; --idx) {
+			cout << toString(H[idx]);
+			if (idx > 0) cout << ' ';
+		}
+		return 0;
+	}
+	
+	vector<ll> H = mod > 0 ? multiplyMod(F, G, mod) : multiply(F, G);
 	int sz = H.size();
 	for (int idx = sz - 1; idx >= 0; --idx) {
 		cout << H[idx];
@@ -108,4 +1255,3 @@ int main() {
 	}
 	return 0;
 }
-
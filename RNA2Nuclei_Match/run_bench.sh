@@ -1,42 +1,30 @@
 #!/bin/bash
 
-# 用法: ./run_bench.sh brute_force,kdtree,lsh
+# 用法: ./run_bench.sh brute_force,kdtree,lsh,grid,polygon
+# 由 build/bench 在同一程序内完成建索引、查询计时、时延分位数、峰值内存与 recall 统计，
+# 每个方法追加一行到 results/results.csv。
 
-METHODS=${1:-brute_force,kdtree,lsh}
+# 数据与结果路径相对于项目根目录，从任意目录调用都先切换过去
+cd "$(dirname "$0")" || exit 1
+
+METHODS=${1:-brute_force,kdtree,lsh,grid,polygon}
 DATA_DIR=data
 RESULTS_DIR=results
-LOG_DIR=$RESULTS_DIR/logs
-
-mkdir -p $LOG_DIR
 
-IFS=',' read -ra METHOD_LIST <<< "$METHODS"
+mkdir -p $RESULTS_DIR
 
 NUCLEI_FILE="$DATA_DIR/nuclei.csv"
 SPOTS_FILE="$DATA_DIR/spots.csv"
+# 可选的细胞核分割多边形，仅 polygon 方法使用
+POLYGONS_FILE="$DATA_DIR/polygons.csv"
 DATASET_NAME="default"
 
-for METHOD in "${METHOD_LIST[@]}"; do
-    echo "运行算法: $METHOD"
-
-    EXEC_PATH="build/$METHOD"
-    OUT_FILE="$LOG_DIR/${METHOD}_${DATASET_NAME}.csv"
-
-    $EXEC_PATH --nuclei "$NUCLEI_FILE" --spots "$SPOTS_FILE" --out "$OUT_FILE"
+EXTRA_ARGS=()
+if [ -f "$POLYGONS_FILE" ]; then
+    EXTRA_ARGS=(--polygons "$POLYGONS_FILE")
+fi
 
-
-    # 计算 recall
-    RECALL=$(python3 -c "
-import pandas as pd
-true_df = pd.read_csv('$SPOTS_FILE')
-pred_df = pd.read_csv('$OUT_FILE')
-merged = pd.merge(true_df, pred_df, on='spot_id', suffixes=('_true', '_pred'))
-correct = (merged['nucleus_id_true'] == merged['nucleus_id_pred']).sum()
-recall = correct / len(true_df)
-print(round(recall, 4))
-    ")
-
-    echo "$DATASET_NAME,$METHOD,$LATENCY,$RECALL" >> "$RESULTS_DIR/results.csv"
-done
+build/bench --nuclei "$NUCLEI_FILE" --spots "$SPOTS_FILE" --methods "$METHODS" \
+    --dataset "$DATASET_NAME" --results "$RESULTS_DIR/results.csv" "${EXTRA_ARGS[@]}"
 
 echo "运行完成。所有结果已记录到 $RESULTS_DIR/results.csv"
-
@@ -5,73 +5,46 @@ import pandas as pd
 import matplotlib.pyplot as plt
 from pathlib import Path
 
-def calculate_recall(true_matches_file, pred_matches_file):
-    """计算预测匹配的准确率"""
-    true_df = pd.read_csv(true_matches_file)
-    pred_df = pd.read_csv(pred_matches_file)
-    
-    merged_df = pd.merge(true_df, pred_df, on='spot_id', suffixes=('_true', '_pred'))
-    correct_matches = (merged_df['nucleus_id_true'] == merged_df['nucleus_id_pred']).sum()
-    
-    return correct_matches / len(true_df)
-
-def analyze_results(data_dir, logs_dir, output_dir):
-    """分析结果并生成可视化"""
+def analyze_results(results_file, output_dir):
+    """读取 build/bench 写出的 results.csv 并生成可视化"""
     # 创建输出目录
     Path(output_dir).mkdir(parents=True, exist_ok=True)
     
-    # 读取运行时间数据
-    timing_df = pd.read_csv(os.path.join(logs_dir, 'timing.csv'),
-                           names=['method', 'dataset', 'latency'])
-    
-    # 计算每个方法在每个数据集上的准确率
-    recalls = []
-    for _, row in timing_df.iterrows():
-        method, dataset = row['method'], row['dataset']
-        true_file = os.path.join(data_dir, f'spots_{dataset}.csv')
-        pred_file = os.path.join(logs_dir, f'{method}_{dataset}.csv')
-        recall = calculate_recall(true_file, pred_file)
-        recalls.append(recall)
-    
-    timing_df['recall'] = recalls
+    # 每行是一个数据集上一个方法的测量结果
+    df = pd.read_csv(results_file)
     
-    # 绘制性能对比图
-    plt.figure(figsize=(12, 5))
-    
-    # 延迟对比
-    plt.subplot(1, 2, 1)
-    for method in timing_df['method'].unique():
-        method_data = timing_df[timing_df['method'] == method]
-        plt.plot(method_data['dataset'], method_data['latency'], 'o-', label=method)
-    plt.title('查询延迟对比')
-    plt.xlabel('数据集')
-    plt.ylabel('延迟 (秒)')
-    plt.xticks(rotation=45)
-    plt.legend()
-    plt.grid(True)
-    
-    # 准确率对比
-    plt.subplot(1, 2, 2)
-    for method in timing_df['method'].unique():
-        method_data = timing_df[timing_df['method'] == method]
-        plt.plot(method_data['dataset'], method_data['recall'], 'o-', label=method)
-    plt.title('准确率对比')
-    plt.xlabel('数据集')
-    plt.ylabel('Recall')
-    plt.xticks(rotation=45)
-    plt.legend()
-    plt.grid(True)
+    # 绘制性能对比图：吞吐、时延分位数、准确率、峰值内存
+    plt.figure(figsize=(12, 9))
+    panels = [
+        ('spots_per_s', '查询吞吐对比', '吞吐 (spots/s)'),
+        ('latency_p99_us', '单查询 p99 时延对比', '时延 (微秒)'),
+        ('recall', '准确率对比', 'Recall'),
+        ('peak_rss_kb', '内存峰值对比', '峰值内存 (KB)'),
+    ]
+    for k, (column, title, ylabel) in enumerate(panels):
+        plt.subplot(2, 2, k + 1)
+        for method in df['method'].unique():
+            method_data = df[df['method'] == method]
+            plt.plot(method_data['dataset'], method_data[column], 'o-', label=method)
+        plt.title(title)
+        plt.xlabel('数据集')
+        plt.ylabel(ylabel)
+        plt.xticks(rotation=45)
+        plt.legend()
+        plt.grid(True)
     
     plt.tight_layout()
     plt.savefig(os.path.join(output_dir, 'performance_comparison.png'))
     plt.close()
     
     # 保存详细结果
-    timing_df.to_csv(os.path.join(output_dir, 'benchmark_results.csv'), index=False)
+    df.to_csv(os.path.join(output_dir, 'benchmark_results.csv'), index=False)
     
     # 生成汇总统计
-    summary = timing_df.groupby('method').agg({
-        'latency': ['mean', 'std', 'min', 'max'],
+    summary = df.groupby('method').agg({
+        'spots_per_s': ['mean', 'min', 'max'],
+        'latency_p50_us': ['mean', 'min', 'max'],
+        'latency_p99_us': ['mean', 'min', 'max'],
         'recall': ['mean', 'std', 'min', 'max']
     }).round(4)
     
@@ -82,17 +55,51 @@ def analyze_results(data_dir, logs_dir, output_dir):
     print(f"性能对比图已保存到: {os.path.join(output_dir, 'performance_comparison.png')}")
     print(f"统计摘要已保存到: {os.path.join(output_dir, 'summary_statistics.csv')}")
 
+def plot_lsh_sweep(sweep_file, output_dir):
+    """读取 ./lsh --sweep 的输出，画 recall 与吞吐的关系并标出 Pareto 前沿"""
+    Path(output_dir).mkdir(parents=True, exist_ok=True)
+    df = pd.read_csv(sweep_file)
+    
+    plt.figure(figsize=(8, 6))
+    for probes in sorted(df['probes'].unique()):
+        part = df[df['probes'] == probes]
+        plt.scatter(part['queries_per_s'], part['recall'], label=f'probes={probes}')
+    
+    # 吞吐从高到低扫描，recall 创新高的点构成前沿
+    front = df.sort_values('queries_per_s', ascending=False)
+    front = front[front['recall'] >= front['recall'].cummax()]
+    plt.plot(front['queries_per_s'], front['recall'], 'k--', label='Pareto 前沿')
+    for _, row in front.iterrows():
+        plt.annotate(f"L={row['tables']:.0f},k={row['functions']:.0f},w={row['width']:g},T={row['probes']:.0f}",
+                     (row['queries_per_s'], row['recall']), fontsize=7,
+                     xytext=(4, -8), textcoords='offset points')
+    plt.xscale('log')
+    plt.title('LSH 参数扫描：recall 与吞吐')
+    plt.xlabel('吞吐 (queries/s)')
+    plt.ylabel('Recall（相对精确最近邻）')
+    plt.legend()
+    plt.grid(True)
+    plt.tight_layout()
+    plt.savefig(os.path.join(output_dir, 'lsh_sweep.png'))
+    plt.close()
+    
+    front.to_csv(os.path.join(output_dir, 'lsh_pareto.csv'), index=False)
+    print(f"LSH 扫描曲线已保存到: {os.path.join(output_dir, 'lsh_sweep.png')}")
+
 def main():
     parser = argparse.ArgumentParser(description='分析算法性能结果并生成可视化')
-    parser.add_argument('--data', type=str, default='data',
-                        help='原始数据集目录路径')
-    parser.add_argument('--logs', type=str, default='results/logs',
-                        help='算法输出日志目录路径')
+    parser.add_argument('--results', type=str, default='results/results.csv',
+                        help='build/bench 输出的结果文件路径')
     parser.add_argument('--output', type=str, default='results/figures',
                         help='可视化结果输出目录路径')
+    parser.add_argument('--sweep', type=str, default=None,
+                        help='./lsh --sweep 输出的参数扫描结果，给出时额外绘制 recall-吞吐曲线')
     
     args = parser.parse_args()
-    analyze_results(args.data, args.logs, args.output)
+    if os.path.exists(args.results):
+        analyze_results(args.results, args.output)
+    if args.sweep:
+        plot_lsh_sweep(args.sweep, args.output)
 
 if __name__ == '__main__':
     main() 
\ No newline at end of file
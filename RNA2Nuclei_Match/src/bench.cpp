@@ -0,0 +1,292 @@
+#include "brute_force.h"
+#include "kdtree.h"
+#include "lsh.h"
+#include "grid.h"
+#include "polygon.h"
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
+
+// 单查询时延的采样数：从 spots 中等间隔抽取
+const size_t LATENCY_SAMPLES = 10000;
+// 逐个计时的查询结果写到这里，防止被优化掉
+volatile int latencySink = 0;
+
+// 所有方法共用的输入，父进程载入一次
+struct BenchInput {
+    PointArray nuclei;
+    PointArray spots;
+    NucleusShapes shapes;
+    double maxDist = NO_MAX_DIST;
+};
+
+// 一个方法的测量结果（子进程经管道整体传回，只含定长字段）
+struct BenchResult {
+    double buildMs = 0;
+    double queryMs = 0;
+    double spotsPerSec = 0;
+    double p50Us = 0, p90Us = 0, p99Us = 0, maxUs = 0;
+    double recall = 0;
+    long peakRssKb = -1;
+};
+
+// 最近秩法取分位数，lat 已升序
+inline double percentile(const std::vector<double>& lat, double p) {
+    if (lat.empty()) return 0.0;
+    size_t rank = (size_t)std::ceil(p * lat.size());
+    return lat[std::min(std::max(rank, (size_t)1), lat.size()) - 1];
+}
+
+// 统一的测量流程：build() 建索引，batch(index) 整批查询返回 nucleus 下标，
+// single(index, q) 单独查询一个 D 维点，用于逐个计时得到时延分布
+template <int D, typename Build, typename Batch, typename Single>
+BenchResult measure(const BenchInput& in, Build build, Batch batch, Single single) {
+    BenchResult r;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    auto index = build();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::vector<int> nearest = batch(index);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    // 建索引可能不足 1 ms，这里保留小数
+    r.buildMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    r.queryMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    r.spotsPerSec = r.queryMs > 0 ? in.spots.size() / (r.queryMs / 1000.0) : 0.0;
+
+    // 与 spots 文件中的 nucleus_id 比较，未分配记为 -1
+    size_t correct = 0;
+    for (size_t i = 0; i < nearest.size(); ++i) {
+        int id = nearest[i] < 0 ? -1 : in.nuclei.id[nearest[i]];
+        if (id == in.spots.nucleus_id[i]) ++correct;
+    }
+    r.recall = in.spots.size() > 0 ? (double)correct / in.spots.size() : 0.0;
+
+    // 单线程逐个计时
+    size_t n = in.spots.size();
+    size_t stride = std::max(n / LATENCY_SAMPLES, (size_t)1);
+    std::vector<double> lat;
+    lat.reserve(std::min(n, LATENCY_SAMPLES));
+    int sink = 0;
+    double q[D];
+    for (size_t i = 0; i < n && lat.size() < LATENCY_SAMPLES; i += stride) {
+        in.spots.point<D>(i, q);
+        auto s = std::chrono::high_resolution_clock::now();
+        sink ^= single(index, q);
+        auto e = std::chrono::high_resolution_clock::now();
+        lat.push_back(std::chrono::duration<double, std::micro>(e - s).count());
+    }
+    latencySink = sink;
+    std::sort(lat.begin(), lat.end());
+    r.p50Us = percentile(lat, 0.50);
+    r.p90Us = percentile(lat, 0.90);
+    r.p99Us = percentile(lat, 0.99);
+    r.maxUs = lat.empty() ? 0.0 : lat.back();
+    return r;
+}
+
+// 在当前进程中运行一个 D 维方法，未知方法或不支持该维数的方法返回 false
+template <int D>
+bool runMethod(const std::string& method, const BenchInput& in, BenchResult& r) {
+    const double bound2 = searchBound2(in.maxDist);
+    if (method == "brute_force") {
+        // 暴力匹配的"索引"只是 nucleus 坐标的副本
+        r = measure<D>(in, [&]() { return BruteForceIndex<D>(in.nuclei); },
+            [&](const BruteForceIndex<D>& b) { return b.findNearestBatch(in.spots, in.maxDist); },
+            [&](const BruteForceIndex<D>& b, const double* q) { return b.findNearest(q, bound2); });
+    } else if (method == "kdtree") {
+        r = measure<D>(in, [&]() { return KDTree<D>(in.nuclei); },
+            [&](const KDTree<D>& t) { return t.findNearestBatch(in.spots, in.maxDist); },
+            [&](const KDTree<D>& t, const double* q) { return t.findNearest(q, bound2); });
+    } else if (method == "lsh") {
+        LSHScratch scratch(in.nuclei.size());
+        r = measure<D>(in, [&]() { LSH<D> lsh; lsh.build(in.nuclei); return lsh; },
+            [&](const LSH<D>& l) { return l.findNearestBatch(in.spots, in.maxDist); },
+            [&](const LSH<D>& l, const double* q) { return l.findNearest(q, bound2, scratch); });
+    } else if (method == "grid" || method == "polygon") {
+        // 网格与形状匹配只支持 2D
+        if constexpr (D == 2) {
+            if (method == "grid") {
+                r = measure<D>(in, [&]() { return UniformGrid(in.nuclei); },
+                    [&](const UniformGrid& g) { return g.findNearestBatch(in.spots, in.maxDist); },
+                    [&](const UniformGrid& g, const double* q) { return g.findNearest(q[0], q[1], bound2); });
+            } else {
+                r = measure<D>(in, [&]() { return NucleusShapeIndex(in.shapes); },
+                    [&](const NucleusShapeIndex& s) { return s.findNearestBatch(in.spots, in.maxDist); },
+                    [&](const NucleusShapeIndex& s, const double* q) { return s.findNearest(q[0], q[1], in.maxDist); });
+            }
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool runMethod(const std::string& method, const BenchInput& in, BenchResult& r) {
+    return in.spots.dims == 3 ? runMethod<3>(method, in, r) : runMethod<2>(method, in, r);
+}
+
+// 每个方法在独立的子进程中运行，峰值内存取子进程的 ru_maxrss（含继承的输入数据），
+// 各方法互不影响。Windows 下没有 fork，在本进程中依次运行，峰值内存为进程累计峰值。
+bool runIsolated(const std::string& method, const BenchInput& in, BenchResult& r) {
+#ifdef _WIN32
+    if (!runMethod(method, in, r)) return false;
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        r.peakRssKb = (long)(pmc.PeakWorkingSetSize / 1024);
+    }
+    return true;
+#else
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        BenchResult child;
+        bool ok = runMethod(method, in, child);
+        if (ok && write(fds[1], &child, sizeof(child)) != (ssize_t)sizeof(child)) ok = false;
+        close(fds[1]);
+        _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], &r, sizeof(r));
+    close(fds[0]);
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) return false;
+    if (got != (ssize_t)sizeof(r) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return false;
+#ifdef __APPLE__
+    r.peakRssKb = usage.ru_maxrss / 1024;  // macOS 以字节为单位
+#else
+    r.peakRssKb = usage.ru_maxrss;
+#endif
+    return true;
+#endif
+}
+
+void printUsage() {
+    std::cout << "Usage: ./bench --nuclei <nuclei_file> --spots <spots_file> "
+                 "[--methods brute_force,kdtree,lsh,grid,polygon] [--polygons <polygons_file>] "
+                 "[--max-dist <d>] [--dataset <name>] [--results <csv>]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string nucleiFile, spotsFile, polygonsFile;
+    std::string methods = "brute_force,kdtree,lsh,grid,polygon";
+    std::string dataset = "default";
+    std::string resultsFile = "results/results.csv";
+    BenchInput in;
+
+    // 解析命令行参数
+    for (int i = 1; i < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--nuclei") nucleiFile = argv[i + 1];
+        else if (arg == "--spots") spotsFile = argv[i + 1];
+        else if (arg == "--polygons") polygonsFile = argv[i + 1];
+        else if (arg == "--methods") methods = argv[i + 1];
+        else if (arg == "--max-dist") in.maxDist = std::stod(argv[i + 1]);
+        else if (arg == "--dataset") dataset = argv[i + 1];
+        else if (arg == "--results") resultsFile = argv[i + 1];
+    }
+
+    // 负数或 NaN 的 --max-dist 没有意义（平方后会被当成正数），直接报错
+    if (!validMaxDist(in.maxDist)) {
+        std::cerr << "Error: --max-dist must be a non-negative number" << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    if (nucleiFile.empty() || spotsFile.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    // 读取数据（只读一次，各方法共用）
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    in.nuclei = readPointArrayCSV(nucleiFile);
+    in.spots = readPointArrayCSV(spotsFile, true);
+    if (in.nuclei.dims != in.spots.dims) {
+        std::cerr << "Error: " << nucleiFile << " and " << spotsFile
+                  << " must both be 2D (id,x,y) or both 3D (id,x,y,z)" << std::endl;
+        return 1;
+    }
+    if (in.nuclei.dims == 2 && methods.find("polygon") != std::string::npos) {
+        in.shapes = readNucleusShapes(in.nuclei, nucleiFile, polygonsFile);
+    }
+    auto loadEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Loading completed in " << elapsedMs(loadStart, loadEnd) << " ms ("
+              << in.nuclei.size() << " nuclei, " << in.spots.size() << " spots)" << std::endl;
+
+    // 结果文件为空时先写表头，之后逐行追加。已有内容但首行不是当前表头（旧格式或其他文件）时
+    // 不在其后追加，而是改名为 <results>.old 另起新文件，避免列数不一致的行混在一起
+    const std::string header = "dataset,method,nuclei,spots,build_ms,query_ms,spots_per_s,"
+                               "latency_p50_us,latency_p90_us,latency_p99_us,latency_max_us,peak_rss_kb,recall";
+    bool needHeader;
+    {
+        std::ifstream probe(resultsFile);
+        std::string firstLine;
+        needHeader = !probe || !std::getline(probe, firstLine);
+        if (!firstLine.empty() && firstLine.back() == '\r') firstLine.pop_back();
+        if (!needHeader && firstLine != header) {
+            probe.close();
+            std::string old = resultsFile + ".old";
+            std::remove(old.c_str());
+            if (std::rename(resultsFile.c_str(), old.c_str()) != 0) {
+                std::cerr << "Error: " << resultsFile << " has an unexpected header and cannot be moved aside"
+                          << std::endl;
+                return 1;
+            }
+            std::cerr << "Warning: " << resultsFile << " has an unexpected header, moved it to " << old
+                      << " and started a new file" << std::endl;
+            needHeader = true;
+        }
+    }
+    std::ofstream out(resultsFile, std::ios::app);
+    if (!out) {
+        std::cerr << "Error: Cannot open file " << resultsFile << std::endl;
+        return 1;
+    }
+    if (needHeader) out << header << "\n";
+
+    std::cout << std::left << std::setw(12) << "method" << std::right
+              << std::setw(12) << "build_ms" << std::setw(12) << "query_ms"
+              << std::setw(14) << "spots/s" << std::setw(10) << "p50_us"
+              << std::setw(10) << "p99_us" << std::setw(12) << "peak_kb"
+              << std::setw(9) << "recall" << std::endl;
+
+    std::stringstream list(methods);
+    std::string method;
+    while (std::getline(list, method, ',')) {
+        if (method.empty()) continue;
+        BenchResult r;
+        if (!runIsolated(method, in, r)) {
+            std::cerr << "Error: method " << method << " failed or is unknown" << std::endl;
+            continue;
+        }
+        std::cout << std::left << std::setw(12) << method << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << r.buildMs << std::setw(12) << r.queryMs
+                  << std::setprecision(0) << std::setw(14) << r.spotsPerSec
+                  << std::setprecision(2) << std::setw(10) << r.p50Us << std::setw(10) << r.p99Us
+                  << std::setw(12) << r.peakRssKb
+                  << std::setprecision(4) << std::setw(9) << r.recall << std::endl;
+        out << dataset << ',' << method << ',' << in.nuclei.size() << ',' << in.spots.size() << ','
+            << std::fixed << std::setprecision(3) << r.buildMs << ',' << r.queryMs << ','
+            << (long long)r.spotsPerSec << ',' << r.p50Us << ',' << r.p90Us << ',' << r.p99Us << ','
+            << r.maxUs << ',' << r.peakRssKb << ',' << std::setprecision(6) << r.recall << '\n';
+    }
+
+    std::cout << "Results appended to " << resultsFile << std::endl;
+    return 0;
+}
@@ -1,39 +1,71 @@
-#include "utils.h"
-#include <algorithm>
+#include "brute_force.h"
 #include <chrono>
 
 void printUsage() {
-    std::cout << "Usage: ./brute_force --nuclei <nuclei_file> --spots <spots_file> --out <output_file>" << std::endl;
+    std::cout << "Usage: ./brute_force --nuclei <nuclei_file> --spots <spots_file> --out <output_file> [--index <index_file>]\n"
+                 "                     [--chunk <rows>] [--max-dist <d>]" << std::endl;
 }
 
-std::vector<std::pair<int, int>> findNearestNuclei(
-    const std::vector<Point>& nuclei,
-    const std::vector<Point>& spots) {
-    
-    std::vector<std::pair<int, int>> matches;
-    matches.reserve(spots.size());
-
-    // 对每个spot找到最近的nucleus
-    for (const auto& spot : spots) {
-        double minDist = std::numeric_limits<double>::max();
-        int nearestNucleusId = -1;
-
-        for (const auto& nucleus : nuclei) {
-            double dist = distance(spot, nucleus);
-            if (dist < minDist) {
-                minDist = dist;
-                nearestNucleusId = nucleus.id;
-            }
-        }
-
-        matches.emplace_back(spot.id, nearestNucleusId);
+// 建索引（或加载 --index）后整批或流式匹配，D 为数据维数
+template <int D>
+int run(const std::string& nucleiFile, const std::string& spotsFile, const std::string& outputFile,
+        const std::string& indexFile, size_t chunkRows, double maxDist) {
+    // 建索引，或从 --index 文件映射加载（计入总耗时）
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    IndexArray<int> ids;
+    BruteForceIndex<D> index;
+    auto build = [&](const PointArray& nuclei) { return BruteForceIndex<D>(nuclei); };
+    if (!openIndex(indexFile, nucleiFile, D == 3 ? "brute_force3d" : "brute_force", index, ids, build)) return 1;
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Index ready in " << elapsedMs(loadStart, buildEnd) << " ms" << std::endl;
+
+    if (chunkRows > 0) {
+        // 流式模式：只常驻 nucleus 索引，spots 分块读取、匹配并追加写出
+        size_t total = streamMatch(spotsFile, outputFile, chunkRows, [&](const PointArray& chunk) {
+            std::vector<int> nearest = index.findNearestBatch(chunk, maxDist);
+            indicesToIds(ids, nearest);
+            return nearest;
+        });
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Streaming completed in " << elapsedMs(buildEnd, end) << " ms" << std::endl;
+        std::cout << "Total matches: " << total << std::endl;
+        std::cout << "Total time (load + match + write): " << elapsedMs(loadStart, end) << " ms" << std::endl;
+        return 0;
     }
 
-    return matches;
+    // 读取数据（单独计时，并计入总耗时）
+    auto spots = readPointArrayCSV(spotsFile, true);
+    auto loadEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Loading completed in " << elapsedMs(buildEnd, loadEnd) << " ms" << std::endl;
+
+    // 计时开始
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // 执行匹配
+    std::vector<int> nearest = index.findNearestBatch(spots, maxDist);
+    auto matches = toMatches(spots, nearest, ids);
+
+    // 计时结束
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // 输出执行时间
+    std::cout << "Matching completed in " << elapsedMs(start, end) << " ms" << std::endl;
+    std::cout << "Total matches: " << matches.size() << std::endl;
+
+    // 保存结果
+    writeResults(outputFile, matches);
+    auto writeEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Writing completed in " << elapsedMs(end, writeEnd) << " ms" << std::endl;
+    std::cout << "Total time (load + match + write): " << elapsedMs(loadStart, writeEnd) << " ms" << std::endl;
+
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
-    std::string nucleiFile, spotsFile, outputFile;
+    std::string nucleiFile, spotsFile, outputFile, indexFile;
+    size_t chunkRows = 0;
+    double maxDist = NO_MAX_DIST;
 
     // 解析命令行参数
     for (int i = 1; i < argc; i += 2) {
@@ -41,33 +73,27 @@ int main(int argc, char* argv[]) {
         if (arg == "--nuclei") nucleiFile = argv[i + 1];
         else if (arg == "--spots") spotsFile = argv[i + 1];
         else if (arg == "--out") outputFile = argv[i + 1];
+        else if (arg == "--index") indexFile = argv[i + 1];
+        else if (arg == "--chunk") chunkRows = std::stoul(argv[i + 1]);
+        else if (arg == "--max-dist") maxDist = std::stod(argv[i + 1]);
     }
 
-    if (nucleiFile.empty() || spotsFile.empty() || outputFile.empty()) {
+    // 负数或 NaN 的 --max-dist 没有意义（平方后会被当成正数），直接报错
+    if (!validMaxDist(maxDist)) {
+        std::cerr << "Error: --max-dist must be a non-negative number" << std::endl;
         printUsage();
         return 1;
     }
 
-    // 读取数据
-    auto nuclei = readPointsFromCSV(nucleiFile);
-    auto spots = readPointsFromCSV(spotsFile, true);
-
-    // 计时开始
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // 执行匹配
-    auto matches = findNearestNuclei(nuclei, spots);
-
-    // 计时结束
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-
-    // 输出执行时间
-    std::cout << "Matching completed in " << duration.count() << " ms" << std::endl;
-    std::cout << "Total matches: " << matches.size() << std::endl;
-
-    // 保存结果
-    writeResults(outputFile, matches);
+    // 已有索引文件时可以不给 nuclei
+    if ((nucleiFile.empty() && !fileExists(indexFile)) || spotsFile.empty() || outputFile.empty()) {
+        printUsage();
+        return 1;
+    }
 
-    return 0;
-} 
\ No newline at end of file
+    // 维数由表头决定：第 4 列为 z 时按 3D 匹配
+    int dims = inputDimensions(nucleiFile, spotsFile);
+    if (dims == 0) return 1;
+    if (dims == 3) return run<3>(nucleiFile, spotsFile, outputFile, indexFile, chunkRows, maxDist);
+    return run<2>(nucleiFile, spotsFile, outputFile, indexFile, chunkRows, maxDist);
+}
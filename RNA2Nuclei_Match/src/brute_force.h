@@ -0,0 +1,180 @@
+#ifndef BRUTE_FORCE_H
+#define BRUTE_FORCE_H
+
+#include "utils.h"
+#include "index_io.h"
+#include <algorithm>
+#include <limits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// 分块大小：一个 nucleus 块的 x/y 共 16KB（3D 再加 8KB 的 z），可常驻 L1；一个 spot 块在该 nucleus 块上全部扫完再换下一块
+const size_t SPOT_TILE = 64;
+const size_t NUCLEI_TILE = 1024;
+
+// 在 nucleus 区间 [begin, end) 中查找距查询点 q 最近的点，比较平方距离；n[a] 为第 a 维坐标数组。
+// 维数 D（2 或 3）是模板参数，各维的累加在编译期展开，2D 与原先的 dx*dx + dy*dy 逐位一致。
+// 只有严格更小才更新，且区间按编号递增处理，因此距离相同时保留下标最小者，
+// 与逐个比较 distance() 的原始实现保持同样的平局规则。
+template <int D>
+inline void nearestInTile(const double* q, const double* const* n,
+                          size_t begin, size_t end,
+                          double& bestD2, int& bestIdx) {
+    size_t j = begin;
+#ifdef __AVX2__
+    if (end - begin >= 4) {
+        __m256d vq[D];
+        for (int a = 0; a < D; ++a) vq[a] = _mm256_set1_pd(q[a]);
+        const __m256d step = _mm256_set1_pd(4.0);
+        __m256d vbest = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+        __m256d vbestIdx = _mm256_set1_pd(-1.0);
+        __m256d vidx = _mm256_setr_pd((double)j, (double)j + 1, (double)j + 2, (double)j + 3);
+        for (; j + 4 <= end; j += 4) {
+            // 不使用 FMA，保证与标量逐维平方累加的结果逐位一致
+            __m256d diff = _mm256_sub_pd(vq[0], _mm256_loadu_pd(n[0] + j));
+            __m256d d2 = _mm256_mul_pd(diff, diff);
+            for (int a = 1; a < D; ++a) {
+                diff = _mm256_sub_pd(vq[a], _mm256_loadu_pd(n[a] + j));
+                d2 = _mm256_add_pd(d2, _mm256_mul_pd(diff, diff));
+            }
+            __m256d lt = _mm256_cmp_pd(d2, vbest, _CMP_LT_OQ);
+            vbest = _mm256_blendv_pd(vbest, d2, lt);
+            vbestIdx = _mm256_blendv_pd(vbestIdx, vidx, lt);
+            vidx = _mm256_add_pd(vidx, step);
+        }
+        // 归约各通道：距离更小者胜，距离相同取下标更小者
+        alignas(32) double laneD2[4];
+        alignas(32) double laneIdx[4];
+        _mm256_store_pd(laneD2, vbest);
+        _mm256_store_pd(laneIdx, vbestIdx);
+        double tileD2 = laneD2[0];
+        double tileIdx = laneIdx[0];
+        for (int l = 1; l < 4; ++l) {
+            if (laneD2[l] < tileD2 || (laneD2[l] == tileD2 && laneIdx[l] < tileIdx)) {
+                tileD2 = laneD2[l];
+                tileIdx = laneIdx[l];
+            }
+        }
+        // 之前的块下标都更小，平局时保留已有结果
+        if (tileIdx >= 0 && tileD2 < bestD2) {
+            bestD2 = tileD2;
+            bestIdx = (int)tileIdx;
+        }
+    }
+#endif
+    for (; j < end; ++j) {
+        double diff = q[0] - n[0][j];
+        double d2 = diff * diff;
+        for (int a = 1; a < D; ++a) {
+            diff = q[a] - n[a][j];
+            d2 += diff * diff;
+        }
+        if (d2 < bestD2) {
+            bestD2 = d2;
+            bestIdx = (int)j;
+        }
+    }
+}
+
+// 返回每个 spot 最近 nucleus 的下标（nucleus 各维坐标为 n[0..D)，共 numNuclei 个），
+// 没有 nucleus 或超出 maxDist 时为 -1
+template <int D>
+inline std::vector<int> findNearestIndices(
+    const double* const* n, size_t numNuclei,
+    const PointArray& spots,
+    double maxDist = NO_MAX_DIST) {
+    
+    std::vector<int> nearest(spots.size());
+    const double bound2 = searchBound2(maxDist);
+
+    // 多线程按 spot 块划分；每个 spot 块依次扫过所有 nucleus 块
+    parallelFor(spots.size(), SPOT_TILE, [&](size_t sBegin, size_t sEnd) {
+        double q[SPOT_TILE][D];
+        double bestD2[SPOT_TILE];
+        int bestIdx[SPOT_TILE];
+        for (size_t i = sBegin; i < sEnd; ++i) {
+            spots.point<D>(i, q[i - sBegin]);
+            bestD2[i - sBegin] = bound2;
+            bestIdx[i - sBegin] = -1;
+        }
+        for (size_t nBegin = 0; nBegin < numNuclei; nBegin += NUCLEI_TILE) {
+            size_t nEnd = std::min(numNuclei, nBegin + NUCLEI_TILE);
+            for (size_t i = sBegin; i < sEnd; ++i) {
+                nearestInTile<D>(q[i - sBegin], n, nBegin, nEnd, bestD2[i - sBegin], bestIdx[i - sBegin]);
+            }
+        }
+        for (size_t i = sBegin; i < sEnd; ++i) {
+            nearest[i] = bestIdx[i - sBegin];
+        }
+    });
+
+    return nearest;
+}
+
+// 按 nuclei 的维数选择 2D 或 3D 实现
+inline std::vector<int> findNearestIndices(
+    const PointArray& nuclei,
+    const PointArray& spots,
+    double maxDist = NO_MAX_DIST) {
+    const double* n[3] = {nuclei.x.data(), nuclei.y.data(), nuclei.z.data()};
+    if (nuclei.dims == 3) return findNearestIndices<3>(n, nuclei.size(), spots, maxDist);
+    return findNearestIndices<2>(n, nuclei.size(), spots, maxDist);
+}
+
+// 暴力匹配没有真正的索引，只保存 nucleus 坐标，使 --index 的用法与其他方法一致
+template <int D = 2>
+class BruteForceIndex {
+private:
+    IndexArray<double> coords[D];
+
+    void columns(const double** n) const {
+        for (int a = 0; a < D; ++a) n[a] = coords[a].data();
+    }
+
+public:
+    BruteForceIndex() = default;
+
+    BruteForceIndex(const PointArray& nuclei) {
+        for (int a = 0; a < D; ++a) coords[a] = nuclei.coord(a);
+    }
+
+    int findNearest(const double* q, double bound2) const {
+        const double* n[D];
+        columns(n);
+        double bestD2 = bound2;
+        int bestIdx = -1;
+        nearestInTile<D>(q, n, 0, coords[0].size(), bestD2, bestIdx);
+        return bestIdx;
+    }
+
+    std::vector<int> findNearestBatch(const PointArray& spots, double maxDist = NO_MAX_DIST) const {
+        const double* n[D];
+        columns(n);
+        return findNearestIndices<D>(n, coords[0].size(), spots, maxDist);
+    }
+
+    void save(IndexWriter& out) const {
+        for (int a = 0; a < D; ++a) out.array(coords[a]);
+    }
+    void load(IndexReader& in) {
+        for (int a = 0; a < D; ++a) in.array(coords[a]);
+    }
+};
+
+inline std::vector<std::pair<int, int>> findNearestNuclei(
+    const PointArray& nuclei,
+    const PointArray& spots,
+    double maxDist = NO_MAX_DIST) {
+    
+    std::vector<int> nearest = findNearestIndices(nuclei, spots, maxDist);
+
+    std::vector<std::pair<int, int>> matches(spots.size());
+    for (size_t i = 0; i < spots.size(); ++i) {
+        matches[i] = std::make_pair(spots.id[i], nearest[i] < 0 ? -1 : nuclei.id[nearest[i]]);
+    }
+
+    return matches;
+}
+
+#endif // BRUTE_FORCE_H
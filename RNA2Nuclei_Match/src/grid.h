@@ -0,0 +1,209 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include "utils.h"
+#include "index_io.h"
+#include <algorithm>
+#include <limits>
+
+// 每个格子期望容纳的 nucleus 数量
+const double GRID_NUCLEI_PER_CELL = 2.0;
+// 每个线程一次领取的查询数
+const size_t GRID_QUERY_GRAIN = 1024;
+
+// 均匀网格索引
+// 格子边长按 nucleus 密度确定，桶采用 CSR 布局：cellStart[c]..cellStart[c+1]
+// 是格子 c 中的 nucleus 在重排后坐标数组 xs/ys 中的区间。
+class UniformGrid {
+private:
+    double minX = 0, minY = 0;
+    double cellSize = 1.0;
+    int gridWidth = 0, gridHeight = 0;
+    IndexArray<int> cellStart;
+    IndexArray<double> xs, ys;
+    IndexArray<int> index;  // 重排后第 i 个点在原 nuclei 中的下标
+
+    inline int cellX(double x) const {
+        int gx = (int)std::floor((x - minX) / cellSize);
+        return std::min(std::max(gx, 0), gridWidth - 1);
+    }
+    inline int cellY(double y) const {
+        int gy = (int)std::floor((y - minY) / cellSize);
+        return std::min(std::max(gy, 0), gridHeight - 1);
+    }
+
+    // 查询点到格子 (gx, gy) 的最小平方距离
+    inline double cellMinD2(double qx, double qy, int gx, int gy) const {
+        double x0 = minX + gx * cellSize;
+        double y0 = minY + gy * cellSize;
+        double dx = qx < x0 ? x0 - qx : (qx > x0 + cellSize ? qx - x0 - cellSize : 0.0);
+        double dy = qy < y0 ? y0 - qy : (qy > y0 + cellSize ? qy - y0 - cellSize : 0.0);
+        return dx * dx + dy * dy;
+    }
+
+    // 扫描一个格子，距离相同时取下标最小者，与暴力匹配结果一致
+    inline void scanCell(int c, double qx, double qy, double& bestD2, int& bestIdx) const {
+        for (int i = cellStart[c]; i < cellStart[c + 1]; ++i) {
+            double dx = qx - xs[i];
+            double dy = qy - ys[i];
+            double d2 = dx * dx + dy * dy;
+            if (d2 < bestD2 || (d2 == bestD2 && index[i] < bestIdx)) {
+                bestD2 = d2;
+                bestIdx = index[i];
+            }
+        }
+    }
+
+public:
+    UniformGrid() = default;
+
+    UniformGrid(const PointArray& points) {
+        size_t n = points.size();
+        if (n == 0) return;
+        minX = *std::min_element(points.x.begin(), points.x.end());
+        minY = *std::min_element(points.y.begin(), points.y.end());
+        double maxX = *std::max_element(points.x.begin(), points.x.end());
+        double maxY = *std::max_element(points.y.begin(), points.y.end());
+        double spanX = std::max(maxX - minX, 1e-9);
+        double spanY = std::max(maxY - minY, 1e-9);
+
+        // 让平均每格约 GRID_NUCLEI_PER_CELL 个点
+        cellSize = std::sqrt(spanX * spanY * GRID_NUCLEI_PER_CELL / n);
+        cellSize = std::max(cellSize, std::max(spanX, spanY) / 4096.0);
+        gridWidth = (int)(spanX / cellSize) + 1;
+        gridHeight = (int)(spanY / cellSize) + 1;
+
+        // 计数 -> 前缀和 -> 回填，得到 CSR 桶
+        std::vector<int> cellOf(n);
+        std::vector<int> start((size_t)gridWidth * gridHeight + 1, 0);
+        for (size_t i = 0; i < n; ++i) {
+            cellOf[i] = cellY(points.y[i]) * gridWidth + cellX(points.x[i]);
+            start[cellOf[i] + 1]++;
+        }
+        for (size_t c = 1; c < start.size(); ++c) {
+            start[c] += start[c - 1];
+        }
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        std::vector<double> px(n), py(n);
+        std::vector<int> order(n);
+        for (size_t i = 0; i < n; ++i) {
+            int pos = fill[cellOf[i]]++;
+            px[pos] = points.x[i];
+            py[pos] = points.y[i];
+            order[pos] = (int)i;
+        }
+        cellStart = std::move(start);
+        xs = std::move(px);
+        ys = std::move(py);
+        index = std::move(order);
+    }
+
+    // 写出 / 映射读回索引，数组顺序两边一致
+    void save(IndexWriter& out) const {
+        out.value(minX);
+        out.value(minY);
+        out.value(cellSize);
+        out.value(gridWidth);
+        out.value(gridHeight);
+        out.array(cellStart);
+        out.array(xs);
+        out.array(ys);
+        out.array(index);
+    }
+    void load(IndexReader& in) {
+        minX = in.value<double>();
+        minY = in.value<double>();
+        cellSize = in.value<double>();
+        gridWidth = in.value<int>();
+        gridHeight = in.value<int>();
+        in.array(cellStart);
+        in.array(xs);
+        in.array(ys);
+        in.array(index);
+    }
+
+    // 从查询点所在格子向外逐圈搜索，当下一圈的距离下界已超过当前最优时提前结束。
+    // bound2 为初始平方距离上界；返回最近 nucleus 在原数组中的下标，没有点或超出上界时返回 -1。
+    int findNearest(double qx, double qy, double bound2) const {
+        int bestIdx = -1;
+        double bestD2 = bound2;
+        if (index.empty()) return bestIdx;
+
+        // 查询点离整个网格都超出上界，直接判为未分配
+        double ox = qx < minX ? minX - qx : std::max(qx - (minX + gridWidth * cellSize), 0.0);
+        double oy = qy < minY ? minY - qy : std::max(qy - (minY + gridHeight * cellSize), 0.0);
+        if (ox * ox + oy * oy > bestD2) return bestIdx;
+
+        int cx = cellX(qx);
+        int cy = cellY(qy);
+        int maxRing = std::max(std::max(cx, gridWidth - 1 - cx), std::max(cy, gridHeight - 1 - cy));
+        scanCell(cy * gridWidth + cx, qx, qy, bestD2, bestIdx);
+        for (int r = 1; r <= maxRing; ++r) {
+            // 第 r 圈的格子与查询点在网格上的投影至少相隔 r-1 个格子，查询点在网格外时也能据此终止
+            double gap = (r - 1) * cellSize;
+            if (gap * gap > bestD2) break;
+            // 第 r 圈以内的正方形区域边界到查询点的最短距离，是第 r 圈所有点的下界
+            double inner = std::min(std::min(qx - (minX + (cx - r + 1) * cellSize),
+                                             (minX + (cx + r) * cellSize) - qx),
+                                    std::min(qy - (minY + (cy - r + 1) * cellSize),
+                                             (minY + (cy + r) * cellSize) - qy));
+            if (inner > 0 && inner * inner > bestD2) break;
+
+            int x0 = cx - r, x1 = cx + r;
+            int y0 = cy - r, y1 = cy + r;
+            for (int gx = std::max(x0, 0); gx <= std::min(x1, gridWidth - 1); ++gx) {
+                // 上下两行
+                if (y0 >= 0 && cellMinD2(qx, qy, gx, y0) <= bestD2) {
+                    scanCell(y0 * gridWidth + gx, qx, qy, bestD2, bestIdx);
+                }
+                if (y1 < gridHeight && cellMinD2(qx, qy, gx, y1) <= bestD2) {
+                    scanCell(y1 * gridWidth + gx, qx, qy, bestD2, bestIdx);
+                }
+            }
+            for (int gy = std::max(y0 + 1, 0); gy <= std::min(y1 - 1, gridHeight - 1); ++gy) {
+                // 左右两列（不含角上已扫描的格子）
+                if (x0 >= 0 && cellMinD2(qx, qy, x0, gy) <= bestD2) {
+                    scanCell(gy * gridWidth + x0, qx, qy, bestD2, bestIdx);
+                }
+                if (x1 < gridWidth && cellMinD2(qx, qy, x1, gy) <= bestD2) {
+                    scanCell(gy * gridWidth + x1, qx, qy, bestD2, bestIdx);
+                }
+            }
+        }
+        return bestIdx;
+    }
+
+    // 批量查询：按 Morton 码顺序多线程查询，结果按原始顺序写回
+    std::vector<int> findNearestBatch(const PointArray& queries, double maxDist = NO_MAX_DIST) const {
+        std::vector<int> result(queries.size());
+        const double bound2 = searchBound2(maxDist);
+        MortonBatch batch(queries);
+        parallelFor(batch.size(), GRID_QUERY_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                result[batch.order[k]] = findNearest(batch.xs[k], batch.ys[k], bound2);
+            }
+        });
+        return result;
+    }
+};
+
+inline std::vector<std::pair<int, int>> findNearestNucleiGrid(
+    const PointArray& nuclei,
+    const PointArray& spots,
+    double maxDist = NO_MAX_DIST) {
+
+    // 构建均匀网格
+    UniformGrid grid(nuclei);
+
+    // 整批查询每个spot的最近nucleus
+    std::vector<int> nearest = grid.findNearestBatch(spots, maxDist);
+
+    std::vector<std::pair<int, int>> matches(spots.size());
+    for (size_t i = 0; i < spots.size(); ++i) {
+        matches[i] = std::make_pair(spots.id[i], nearest[i] < 0 ? -1 : nuclei.id[nearest[i]]);
+    }
+
+    return matches;
+}
+
+#endif // GRID_H
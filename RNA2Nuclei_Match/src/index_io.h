@@ -0,0 +1,227 @@
+#ifndef INDEX_IO_H
+#define INDEX_IO_H
+
+#include "utils.h"
+#include <memory>
+#include <type_traits>
+
+// 索引文件格式版本，数组布局变化时递增
+const uint32_t INDEX_FORMAT_VERSION = 1;
+// 每个数组的起始偏移按缓存行对齐，映射后可直接当作数组使用
+const size_t INDEX_ALIGNMENT = 64;
+
+// 索引中的只读数组：自建索引时持有 std::vector，从索引文件加载时只是指向映射内存的视图，
+// 并持有映射的共享引用，保证索引对象存活期间映射不被解除。查询代码对两者一视同仁。
+template <typename T>
+class IndexArray {
+    static_assert(std::is_trivially_copyable<T>::value, "index arrays must be trivially copyable");
+
+public:
+    IndexArray() = default;
+    IndexArray(const IndexArray& o) : owned(o.owned), ptr(o.mapping ? o.ptr : owned.data()),
+                                      count(o.count), mapping(o.mapping) {}
+    IndexArray(IndexArray&& o) noexcept = default;
+    IndexArray& operator=(const IndexArray& o) {
+        if (this != &o) {
+            owned = o.owned;
+            mapping = o.mapping;
+            ptr = mapping ? o.ptr : owned.data();
+            count = o.count;
+        }
+        return *this;
+    }
+    IndexArray& operator=(IndexArray&& o) noexcept = default;
+
+    // 接管一个自建的数组
+    IndexArray& operator=(std::vector<T> v) {
+        owned = std::move(v);
+        mapping.reset();
+        ptr = owned.data();
+        count = owned.size();
+        return *this;
+    }
+
+    // 指向映射内存中的 n 个元素
+    void attach(std::shared_ptr<const MappedFile> file, const T* p, size_t n) {
+        owned.clear();
+        owned.shrink_to_fit();
+        mapping = std::move(file);
+        ptr = p;
+        count = n;
+    }
+
+    const T& operator[](size_t i) const { return ptr[i]; }
+    const T* data() const { return ptr; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    std::vector<T> owned;
+    const T* ptr = nullptr;
+    size_t count = 0;
+    std::shared_ptr<const MappedFile> mapping;
+};
+
+// 索引文件头：魔数、版本、字节序标记和索引类型名。
+// 文件按本机字节序与结构体布局写出，只在同类平台之间复用。
+struct IndexFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    char kind[16];
+};
+
+inline IndexFileHeader makeIndexHeader(const std::string& kind) {
+    IndexFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "R2NIDX\0\0", 8);
+    header.version = INDEX_FORMAT_VERSION;
+    header.byteOrder = 0x01020304u;
+    std::strncpy(header.kind, kind.c_str(), sizeof(header.kind) - 1);
+    return header;
+}
+
+// 顺序写出索引：标量按原样写入，数组写入元素个数后对齐到 INDEX_ALIGNMENT 再写数据
+class IndexWriter {
+public:
+    IndexWriter(const std::string& filename, const std::string& kind)
+        : out(filename, std::ios::binary | std::ios::trunc) {
+        IndexFileHeader header = makeIndexHeader(kind);
+        raw(&header, sizeof(header));
+    }
+
+    bool good() const { return (bool)out; }
+
+    template <typename T>
+    void value(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "index values must be trivially copyable");
+        raw(&v, sizeof(T));
+    }
+
+    template <typename T>
+    void array(const IndexArray<T>& a) {
+        value<uint64_t>(a.size());
+        static const char zeros[INDEX_ALIGNMENT] = {};
+        raw(zeros, (INDEX_ALIGNMENT - offset % INDEX_ALIGNMENT) % INDEX_ALIGNMENT);
+        raw(a.data(), a.size() * sizeof(T));
+    }
+
+private:
+    std::ofstream out;
+    uint64_t offset = 0;
+
+    void raw(const void* p, size_t n) {
+        if (n == 0) return;
+        out.write(static_cast<const char*>(p), (std::streamsize)n);
+        offset += n;
+    }
+};
+
+// 映射索引文件并按写出的顺序读回：数组不拷贝，直接指向映射内存。
+// 任一步越界或文件头不符都会置失败标志，之后的读取全部返回空值。
+class IndexReader {
+public:
+    IndexReader(const std::string& filename, const std::string& kind)
+        : file(std::make_shared<const MappedFile>(filename, false)) {
+        IndexFileHeader expect = makeIndexHeader(kind);
+        IndexFileHeader header = value<IndexFileHeader>();
+        if (ok && std::memcmp(&header, &expect, sizeof(header)) != 0) ok = false;
+    }
+
+    bool good() const { return ok; }
+    // 索引自身校验不通过时标记失败
+    void fail() { ok = false; }
+
+    template <typename T>
+    T value() {
+        T v{};
+        if (!ok || file->end() - file->begin() < (std::ptrdiff_t)(offset + sizeof(T))) {
+            ok = false;
+            return v;
+        }
+        std::memcpy(&v, file->begin() + offset, sizeof(T));
+        offset += sizeof(T);
+        return v;
+    }
+
+    template <typename T>
+    void array(IndexArray<T>& a) {
+        uint64_t n = value<uint64_t>();
+        offset += (INDEX_ALIGNMENT - offset % INDEX_ALIGNMENT) % INDEX_ALIGNMENT;
+        size_t available = ok ? (size_t)(file->end() - file->begin()) : 0;
+        if (!ok || offset > available || n > (available - offset) / sizeof(T)) {
+            ok = false;
+            a = std::vector<T>();
+            return;
+        }
+        a.attach(file, reinterpret_cast<const T*>(file->begin() + offset), (size_t)n);
+        offset += (size_t)n * sizeof(T);
+    }
+
+private:
+    std::shared_ptr<const MappedFile> file;
+    size_t offset = 0;
+    bool ok = true;
+};
+
+inline bool fileExists(const std::string& filename) {
+    if (filename.empty()) return false;
+    std::ifstream in(filename, std::ios::binary);
+    return (bool)in;
+}
+
+// --index 的通用流程：索引文件已存在时映射加载（零拷贝，不再读取 nuclei CSV）；
+// 否则读取 nuclei 构建索引，给出了 --index 时再写出，供之后的运行复用。
+// ids 为各 nucleus 的编号，查询得到的下标经它换算为 nucleus_id。
+// 索引文件无效且没有 nuclei 文件可供重建时返回 false。
+template <typename Index, typename Build>
+bool openIndex(const std::string& indexFile, const std::string& nucleiFile, const std::string& kind,
+               Index& index, IndexArray<int>& ids, Build build) {
+    if (fileExists(indexFile)) {
+        IndexReader reader(indexFile, kind);
+        reader.array(ids);
+        index.load(reader);
+        if (reader.good()) {
+            std::cout << "Index loaded from " << indexFile << std::endl;
+            return true;
+        }
+        if (nucleiFile.empty()) {
+            std::cerr << "Error: " << indexFile << " is not a valid " << kind << " index" << std::endl;
+            return false;
+        }
+        std::cerr << "Warning: " << indexFile << " is not a valid " << kind << " index, rebuilding" << std::endl;
+    }
+
+    PointArray nuclei = readPointArrayCSV(nucleiFile);
+    index = build(nuclei);
+    ids = nuclei.id;
+    if (!indexFile.empty()) {
+        IndexWriter writer(indexFile, kind);
+        writer.array(ids);
+        index.save(writer);
+        if (writer.good()) std::cout << "Index saved to " << indexFile << std::endl;
+        else std::cerr << "Error: Cannot write index file " << indexFile << std::endl;
+    }
+    return true;
+}
+
+// 把 nucleus 下标就地换成 nucleus id，-1 保持不变
+inline void indicesToIds(const IndexArray<int>& ids, std::vector<int>& nearest) {
+    for (auto& v : nearest) {
+        if (v >= 0) v = ids[v];
+    }
+}
+
+// 组装 (spot_id, nucleus_id) 结果
+inline std::vector<std::pair<int, int>> toMatches(const PointArray& spots, const std::vector<int>& nearest,
+                                                  const IndexArray<int>& ids) {
+    std::vector<std::pair<int, int>> matches(spots.size());
+    for (size_t i = 0; i < spots.size(); ++i) {
+        matches[i] = std::make_pair(spots.id[i], nearest[i] < 0 ? -1 : ids[nearest[i]]);
+    }
+    return matches;
+}
+
+#endif // INDEX_IO_H
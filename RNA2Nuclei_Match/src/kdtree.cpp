@@ -1,103 +1,71 @@
-#include "utils.h"
-#include <algorithm>
-#include <memory>
+#include "kdtree.h"
 #include <chrono>
-#include <limits>
 
-struct KDNode {
-    Point point;
-    std::unique_ptr<KDNode> left, right;
-    int axis;  // 0 for x, 1 for y
-
-    KDNode(const Point& p, int ax) : point(p), axis(ax) {}
-};
-
-class KDTree {
-private:
-    std::unique_ptr<KDNode> root;
-
-    std::unique_ptr<KDNode> buildTree(std::vector<Point>& points, int depth, int start, int end) {
-        if (start >= end) return nullptr;
-
-        int axis = depth % 2;  // 在x和y轴之间交替
-        int mid = (start + end) / 2;
-
-        // 按当前轴排序
-        std::nth_element(points.begin() + start, points.begin() + mid,
-                        points.begin() + end,
-                        [axis](const Point& a, const Point& b) {
-                            return axis == 0 ? a.x < b.x : a.y < b.y;
-                        });
+void printUsage() {
+    std::cout << "Usage: ./kdtree --nuclei <nuclei_file> --spots <spots_file> --out <output_file> [--index <index_file>]\n"
+                 "                [--chunk <rows>] [--max-dist <d>]" << std::endl;
+}
 
-        auto node = std::make_unique<KDNode>(points[mid], axis);
-        node->left = buildTree(points, depth + 1, start, mid);
-        node->right = buildTree(points, depth + 1, mid + 1, end);
-        return node;
+// 建索引（或加载 --index）后整批或流式匹配，D 为数据维数
+template <int D>
+int run(const std::string& nucleiFile, const std::string& spotsFile, const std::string& outputFile,
+        const std::string& indexFile, size_t chunkRows, double maxDist) {
+    // 建索引，或从 --index 文件映射加载（计入总耗时）
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    IndexArray<int> ids;
+    KDTree<D> index;
+    auto build = [&](const PointArray& nuclei) { return KDTree<D>(nuclei); };
+    if (!openIndex(indexFile, nucleiFile, D == 3 ? "kdtree3d" : "kdtree", index, ids, build)) return 1;
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Index ready in " << elapsedMs(loadStart, buildEnd) << " ms" << std::endl;
+
+    if (chunkRows > 0) {
+        // 流式模式：只常驻 nucleus 索引，spots 分块读取、匹配并追加写出
+        size_t total = streamMatch(spotsFile, outputFile, chunkRows, [&](const PointArray& chunk) {
+            std::vector<int> nearest = index.findNearestBatch(chunk, maxDist);
+            indicesToIds(ids, nearest);
+            return nearest;
+        });
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Streaming completed in " << elapsedMs(buildEnd, end) << " ms" << std::endl;
+        std::cout << "Total matches: " << total << std::endl;
+        std::cout << "Total time (load + match + write): " << elapsedMs(loadStart, end) << " ms" << std::endl;
+        return 0;
     }
 
-    void findNearest(KDNode* node, const Point& target, Point& best, double& bestDist) const {
-        if (!node) return;
-
-        double dist = distance(target, node->point);
-        if (dist < bestDist) {
-            bestDist = dist;
-            best = node->point;
-        }
-
-        double axisDist = (node->axis == 0) ? 
-                         target.x - node->point.x : 
-                         target.y - node->point.y;
+    // 读取数据（单独计时，并计入总耗时）
+    auto spots = readPointArrayCSV(spotsFile, true);
+    auto loadEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Loading completed in " << elapsedMs(buildEnd, loadEnd) << " ms" << std::endl;
 
-        // 递归搜索最可能包含最近点的子树
-        KDNode* first = axisDist <= 0 ? node->left.get() : node->right.get();
-        KDNode* second = axisDist <= 0 ? node->right.get() : node->left.get();
-
-        findNearest(first, target, best, bestDist);
-
-        // 如果另一边可能有更近的点，也要搜索
-        if (axisDist * axisDist < bestDist) {
-            findNearest(second, target, best, bestDist);
-        }
-    }
+    // 计时开始
+    auto start = std::chrono::high_resolution_clock::now();
 
-public:
-    KDTree(std::vector<Point>& points) {
-        root = buildTree(points, 0, 0, points.size());
-    }
+    // 执行匹配
+    std::vector<int> nearest = index.findNearestBatch(spots, maxDist);
+    auto matches = toMatches(spots, nearest, ids);
 
-    Point findNearest(const Point& target) const {
-        Point best;
-        double bestDist = std::numeric_limits<double>::max();
-        findNearest(root.get(), target, best, bestDist);
-        return best;
-    }
-};
+    // 计时结束
+    auto end = std::chrono::high_resolution_clock::now();
 
-void printUsage() {
-    std::cout << "Usage: ./kdtree --nuclei <nuclei_file> --spots <spots_file> --out <output_file>" << std::endl;
-}
+    // 输出执行时间
+    std::cout << "Matching completed in " << elapsedMs(start, end) << " ms" << std::endl;
+    std::cout << "Total matches: " << matches.size() << std::endl;
 
-std::vector<std::pair<int, int>> findNearestNucleiKDTree(
-    std::vector<Point>& nuclei,
-    const std::vector<Point>& spots) {
-    
-    // 构建k-d树
-    KDTree kdtree(nuclei);
-    
-    std::vector<std::pair<int, int>> matches;
-    matches.reserve(spots.size());
-
-    // 对每个spot查找最近的nucleus
-    for (const auto& spot : spots) {
-        Point nearest = kdtree.findNearest(spot);
-        matches.emplace_back(spot.id, nearest.id);
-    }
+    // 保存结果
+    writeResults(outputFile, matches);
+    auto writeEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Writing completed in " << elapsedMs(end, writeEnd) << " ms" << std::endl;
+    std::cout << "Total time (load + match + write): " << elapsedMs(loadStart, writeEnd) << " ms" << std::endl;
 
-    return matches;
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
-    std::string nucleiFile, spotsFile, outputFile;
+    std::string nucleiFile, spotsFile, outputFile, indexFile;
+    size_t chunkRows = 0;
+    double maxDist = NO_MAX_DIST;
 
     // 解析命令行参数
     for (int i = 1; i < argc; i += 2) {
@@ -105,33 +73,27 @@ int main(int argc, char* argv[]) {
         if (arg == "--nuclei") nucleiFile = argv[i + 1];
         else if (arg == "--spots") spotsFile = argv[i + 1];
         else if (arg == "--out") outputFile = argv[i + 1];
+        else if (arg == "--index") indexFile = argv[i + 1];
+        else if (arg == "--chunk") chunkRows = std::stoul(argv[i + 1]);
+        else if (arg == "--max-dist") maxDist = std::stod(argv[i + 1]);
     }
 
-    if (nucleiFile.empty() || spotsFile.empty() || outputFile.empty()) {
+    // 负数或 NaN 的 --max-dist 没有意义（平方后会被当成正数），直接报错
+    if (!validMaxDist(maxDist)) {
+        std::cerr << "Error: --max-dist must be a non-negative number" << std::endl;
         printUsage();
         return 1;
     }
 
-    // 读取数据
-    auto nuclei = readPointsFromCSV(nucleiFile);
-    auto spots = readPointsFromCSV(spotsFile, true);
-
-    // 计时开始
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // 执行匹配
-    auto matches = findNearestNucleiKDTree(nuclei, spots);
-
-    // 计时结束
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-
-    // 输出执行时间
-    std::cout << "Matching completed in " << duration.count() << " ms" << std::endl;
-    std::cout << "Total matches: " << matches.size() << std::endl;
-
-    // 保存结果
-    writeResults(outputFile, matches);
+    // 已有索引文件时可以不给 nuclei
+    if ((nucleiFile.empty() && !fileExists(indexFile)) || spotsFile.empty() || outputFile.empty()) {
+        printUsage();
+        return 1;
+    }
 
-    return 0;
-} 
\ No newline at end of file
+    // 维数由表头决定：第 4 列为 z 时按 3D 匹配
+    int dims = inputDimensions(nucleiFile, spotsFile);
+    if (dims == 0) return 1;
+    if (dims == 3) return run<3>(nucleiFile, spotsFile, outputFile, indexFile, chunkRows, maxDist);
+    return run<2>(nucleiFile, spotsFile, outputFile, indexFile, chunkRows, maxDist);
+}
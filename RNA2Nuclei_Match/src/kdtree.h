@@ -0,0 +1,250 @@
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include "utils.h"
+#include "index_io.h"
+#include <algorithm>
+#include <limits>
+
+// 叶子桶容量
+const int KD_LEAF_SIZE = 8;
+// 每个线程一次领取的查询数
+const size_t KD_QUERY_GRAIN = 1024;
+// 批量查询时提前多少个查询预取其起始叶子
+const size_t KD_PREFETCH_DISTANCE = 4;
+
+// 扁平节点：内部节点记录分割轴、分割值和两个孩子的下标；
+// 叶子（axis == -1）记录其点在重排后坐标数组中的区间 [begin, end)
+struct KDNode {
+    double split;
+    int axis;  // 0 x, 1 y, 2 z, -1 叶子
+    int left, right;  // 内部节点：孩子下标；叶子：begin, end
+};
+
+// 维数 D（2 或 3）为模板参数，坐标、包围盒与查询栈都是定长数组，
+// 各维循环在编译期展开，2D 实例与专门写成 x/y 的版本一样快
+template <int D = 2>
+class KDTree {
+private:
+    IndexArray<KDNode> nodes;
+    // 按叶子顺序重排后的各维坐标（SoA）及其在原 nuclei 中的下标
+    IndexArray<double> coords[D];
+    IndexArray<int> index;
+    // 全部 nucleus 的包围盒
+    double boxMin[D] = {}, boxMax[D] = {};
+
+    static int buildTree(const PointArray& points, std::vector<KDNode>& tree, std::vector<int>& order,
+                         int start, int end) {
+        int nodeId = (int)tree.size();
+        tree.push_back(KDNode());
+        if (end - start <= KD_LEAF_SIZE) {
+            tree[nodeId].axis = -1;
+            tree[nodeId].left = start;
+            tree[nodeId].right = end;
+            return nodeId;
+        }
+
+        // 选择跨度最大的轴切分，避免聚集数据上出现细长的格子；跨度相同时取编号小的轴
+        int axis = 0;
+        double bestSpan = -1.0;
+        for (int a = 0; a < D; ++a) {
+            const std::vector<double>& c = points.coord(a);
+            double lo = std::numeric_limits<double>::max(), hi = -lo;
+            for (int i = start; i < end; ++i) {
+                lo = std::min(lo, c[order[i]]);
+                hi = std::max(hi, c[order[i]]);
+            }
+            if (hi - lo > bestSpan) {
+                bestSpan = hi - lo;
+                axis = a;
+            }
+        }
+        const std::vector<double>& coord = points.coord(axis);
+        int mid = (start + end) / 2;
+
+        std::nth_element(order.begin() + start, order.begin() + mid,
+                         order.begin() + end,
+                         [&coord](int a, int b) { return coord[a] < coord[b]; });
+
+        tree[nodeId].axis = axis;
+        tree[nodeId].split = coord[order[mid]];
+        int left = buildTree(points, tree, order, start, mid);
+        int right = buildTree(points, tree, order, mid, end);
+        tree[nodeId].left = left;
+        tree[nodeId].right = right;
+        return nodeId;
+    }
+
+    // 取第 axis 维分量。循环在编译期展开为比较加选择，不按运行时下标访问，
+    // 查询坐标与栈元素可以留在寄存器中
+    static double component(const double* v, int axis) {
+        double r = v[0];
+        for (int a = 1; a < D; ++a) {
+            if (axis == a) r = v[a];
+        }
+        return r;
+    }
+
+public:
+    KDTree() = default;
+
+    KDTree(const PointArray& points) {
+        int n = (int)points.size();
+        std::vector<int> order(n);
+        for (int i = 0; i < n; ++i) order[i] = i;
+        std::vector<KDNode> tree;
+        tree.reserve(2 * (n / KD_LEAF_SIZE + 1));
+        if (n > 0) buildTree(points, tree, order, 0, n);
+        for (int a = 0; a < D; ++a) {
+            const std::vector<double>& c = points.coord(a);
+            std::vector<double> sorted(n);
+            for (int i = 0; i < n; ++i) sorted[i] = c[order[i]];
+            if (n > 0) {
+                boxMin[a] = *std::min_element(sorted.begin(), sorted.end());
+                boxMax[a] = *std::max_element(sorted.begin(), sorted.end());
+            }
+            coords[a] = std::move(sorted);
+        }
+        nodes = std::move(tree);
+        index = std::move(order);
+    }
+
+    // 写出 / 映射读回索引，数组顺序两边一致
+    void save(IndexWriter& out) const {
+        for (int a = 0; a < D; ++a) {
+            out.value(boxMin[a]);
+            out.value(boxMax[a]);
+        }
+        out.array(nodes);
+        for (int a = 0; a < D; ++a) out.array(coords[a]);
+        out.array(index);
+    }
+    void load(IndexReader& in) {
+        for (int a = 0; a < D; ++a) {
+            boxMin[a] = in.value<double>();
+            boxMax[a] = in.value<double>();
+        }
+        in.array(nodes);
+        for (int a = 0; a < D; ++a) in.array(coords[a]);
+        in.array(index);
+    }
+
+    // 返回最近 nucleus 在原数组中的下标，没有点或超出上界 bound2 时返回 -1。
+    // 用显式栈代替递归，全程比较平方距离；距离相同时取下标最小者，与暴力匹配结果一致。
+    int findNearest(const double* q, double bound2) const {
+        int bestIdx = -1;
+        double bestD2 = bound2;
+        if (nodes.empty()) return bestIdx;
+
+        // 栈元素：节点下标、查询点到该子树包围区域在各轴上的偏移及其平方距离下界
+        struct Entry { int node; double off[D]; double minD2; };
+        Entry root;
+        root.node = 0;
+        root.minD2 = 0.0;
+        for (int a = 0; a < D; ++a) {
+            root.off[a] = q[a] < boxMin[a] ? boxMin[a] - q[a] : (q[a] > boxMax[a] ? q[a] - boxMax[a] : 0.0);
+            root.minD2 += root.off[a] * root.off[a];
+        }
+        // 远离全部 nucleus 的背景点在这里直接返回，无需下降
+        if (root.minD2 > bestD2) return bestIdx;
+
+        const double* c[D];
+        for (int a = 0; a < D; ++a) c[a] = coords[a].data();
+        Entry stack[64];
+        int top = 0;
+        stack[top++] = root;
+        while (top > 0) {
+            Entry e = stack[--top];
+            if (e.minD2 > bestD2) continue;
+            int nodeId = e.node;
+            // 沿近侧一路下降到叶子，远侧子树按其包围区域下界压栈
+            while (nodes[nodeId].axis >= 0) {
+                const KDNode& node = nodes[nodeId];
+                double diff = component(q, node.axis) - node.split;
+                int nearChild = diff < 0 ? node.left : node.right;
+                int farChild = diff < 0 ? node.right : node.left;
+                Entry far = e;
+                far.node = farChild;
+                for (int a = 0; a < D; ++a) {
+                    if (node.axis == a) far.off[a] = std::fabs(diff);
+                }
+                far.minD2 = far.off[0] * far.off[0];
+                for (int a = 1; a < D; ++a) far.minD2 += far.off[a] * far.off[a];
+                if (far.minD2 <= bestD2) stack[top++] = far;
+                nodeId = nearChild;
+            }
+            const KDNode& leaf = nodes[nodeId];
+            for (int i = leaf.left; i < leaf.right; ++i) {
+                double diff = q[0] - c[0][i];
+                double d2 = diff * diff;
+                for (int a = 1; a < D; ++a) {
+                    diff = q[a] - c[a][i];
+                    d2 += diff * diff;
+                }
+                if (d2 < bestD2 || (d2 == bestD2 && index[i] < bestIdx)) {
+                    bestD2 = d2;
+                    bestIdx = index[i];
+                }
+            }
+        }
+        return bestIdx;
+    }
+
+    int findNearest(double qx, double qy, double bound2) const {
+        static_assert(D == 2, "use findNearest(const double*, double) for 3D trees");
+        const double q[2] = {qx, qy};
+        return findNearest(q, bound2);
+    }
+
+    // 预取查询点沿近侧下降到达的起始叶子中的坐标与下标
+    void prefetchLeaf(const double* q) const {
+        if (nodes.empty()) return;
+        int nodeId = 0;
+        while (nodes[nodeId].axis >= 0) {
+            const KDNode& node = nodes[nodeId];
+            nodeId = component(q, node.axis) < node.split ? node.left : node.right;
+        }
+        int begin = nodes[nodeId].left;
+        for (int a = 0; a < D; ++a) prefetchRead(&coords[a][begin]);
+        prefetchRead(&index[begin]);
+    }
+
+    // 批量查询：先按 Morton 码排序并把坐标重排成连续数组，再由多个线程按空间顺序分块查询；
+    // 查询第 k 个点时预取第 k + KD_PREFETCH_DISTANCE 个点的起始叶子，结果按原始顺序写回
+    std::vector<int> findNearestBatch(const PointArray& queries, double maxDist = NO_MAX_DIST) const {
+        std::vector<int> result(queries.size());
+        const double bound2 = searchBound2(maxDist);
+        MortonBatch batch(queries);
+        parallelFor(batch.size(), KD_QUERY_GRAIN, [&](size_t begin, size_t end) {
+            double q[D];
+            for (size_t k = begin; k < end; ++k) {
+                if (k + KD_PREFETCH_DISTANCE < end) {
+                    batch.point<D>(k + KD_PREFETCH_DISTANCE, q);
+                    prefetchLeaf(q);
+                }
+                batch.point<D>(k, q);
+                result[batch.order[k]] = findNearest(q, bound2);
+            }
+        });
+        return result;
+    }
+};
+
+inline std::vector<std::pair<int, int>> findNearestNucleiKDTree(
+    const PointArray& nuclei,
+    const PointArray& spots,
+    double maxDist = NO_MAX_DIST) {
+    
+    // 构建k-d树，整批查询每个spot的最近nucleus
+    std::vector<int> nearest = nuclei.dims == 3 ? KDTree<3>(nuclei).findNearestBatch(spots, maxDist)
+                                                : KDTree<2>(nuclei).findNearestBatch(spots, maxDist);
+
+    std::vector<std::pair<int, int>> matches(spots.size());
+    for (size_t i = 0; i < spots.size(); ++i) {
+        matches[i] = std::make_pair(spots.id[i], nearest[i] < 0 ? -1 : nuclei.id[nearest[i]]);
+    }
+
+    return matches;
+}
+
+#endif // KDTREE_H
@@ -1,139 +1,157 @@
-#include "utils.h"
-#include <random>
-#include <unordered_map>
+#include "lsh.h"
+#include "kdtree.h"
 #include <chrono>
-#include <cmath>
-
-// LSH参数
-const int NUM_HASH_TABLES = 10;  // 哈希表数量
-const int NUM_HASH_FUNCTIONS = 4;  // 每个哈希表的哈希函数数量
-const double W = 4.0;  // LSH的桶宽度
-
-// LSH哈希函数
-class LSHFunction {
-private:
-    std::vector<double> a;  // 随机投影向量
-    double b;  // 随机偏移
-    
-public:
-    LSHFunction() {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::normal_distribution<> normal(0, 1);
-        
-        // 生成2D随机投影向量
-        a = {normal(gen), normal(gen)};
-        std::uniform_real_distribution<> uniform(0, W);
-        b = uniform(gen);
-    }
-    
-    int hash(const Point& p) const {
-        double proj = a[0] * p.x + a[1] * p.y;
-        return static_cast<int>((proj + b) / W);
-    }
-};
-
-// LSH哈希表
-class LSHTable {
-private:
-    std::vector<LSHFunction> hashFunctions;
-    std::unordered_map<std::string, std::vector<Point>> table;
-    
-    std::string getHashKey(const Point& p) const {
-        std::string key;
-        for (const auto& func : hashFunctions) {
-            key += std::to_string(func.hash(p)) + "_";
-        }
-        return key;
-    }
-    
-public:
-    LSHTable() {
-        for (int i = 0; i < NUM_HASH_FUNCTIONS; ++i) {
-            hashFunctions.emplace_back();
-        }
-    }
-    
-    void insert(const Point& p) {
-        std::string key = getHashKey(p);
-        table[key].push_back(p);
-    }
-    
-    std::vector<Point> query(const Point& p) const {
-        std::string key = getHashKey(p);
-        auto it = table.find(key);
-        if (it != table.end()) {
-            return it->second;
-        }
-        return std::vector<Point>();
-    }
-};
-
-class LSH {
-private:
-    std::vector<LSHTable> hashTables;
-    
-public:
-    LSH() {
-        for (int i = 0; i < NUM_HASH_TABLES; ++i) {
-            hashTables.emplace_back();
-        }
+#include <sstream>
+
+void printUsage() {
+    std::cout << "Usage: ./lsh --nuclei <nuclei_file> --spots <spots_file> --out <output_file> [--index <index_file>]\n"
+                 "             [--chunk <rows>] [--max-dist <d>] [--tables <n>] [--functions <n>] [--width <w>]\n"
+                 "             [--probes <n>] [--seed <s>]\n"
+                 "       ./lsh --nuclei <nuclei_file> --spots <spots_file> --sweep <csv> [--max-dist <d>]\n"
+                 "             [--tables <n,...>] [--functions <n,...>] [--width <w,...>] [--probes <n,...>] [--seed <s>]" << std::endl;
+}
+
+// 解析逗号分隔的数值列表
+std::vector<double> parseList(const std::string& text) {
+    std::vector<double> values;
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        if (!item.empty()) values.push_back(std::stod(item));
     }
-    
-    void insert(const Point& p) {
-        for (auto& table : hashTables) {
-            table.insert(p);
-        }
+    return values;
+}
+
+// 参数扫描：对 tables x functions x width x probes 的每个组合建索引并整批查询，
+// recall 以 k-d 树精确最近邻为基准，label_recall 与 spots 文件中的 nucleus_id 比较，
+// 每个组合向 CSV 写一行，供 visualize_results.py 画 recall-吞吐曲线
+template <int D>
+int runSweep(const std::string& nucleiFile, const std::string& spotsFile, const std::string& sweepFile,
+             const std::vector<double>& tables, const std::vector<double>& functions,
+             const std::vector<double>& widths, const std::vector<double>& probes,
+             uint32_t seed, double maxDist) {
+    auto nuclei = readPointArrayCSV(nucleiFile);
+    auto spots = readPointArrayCSV(spotsFile, true);
+    std::vector<int> exact = KDTree<D>(nuclei).findNearestBatch(spots, maxDist);
+
+    std::ofstream out(sweepFile);
+    if (!out) {
+        std::cerr << "Error: Cannot open file " << sweepFile << std::endl;
+        return 1;
     }
-    
-    Point findNearest(const Point& query) const {
-        Point nearest;
-        double minDist = std::numeric_limits<double>::max();
-        
-        // 在所有哈希表中查找候选点
-        for (const auto& table : hashTables) {
-            auto candidates = table.query(query);
-            for (const auto& candidate : candidates) {
-                double dist = distance(query, candidate);
-                if (dist < minDist) {
-                    minDist = dist;
-                    nearest = candidate;
-                }
-            }
+    out << "tables,functions,width,probes,build_ms,query_ms,queries_per_s,recall,label_recall\n";
+
+    for (double t : tables) for (double f : functions) for (double w : widths) for (double pr : probes) {
+        LSHParams params;
+        params.numTables = (int)t;
+        params.numFunctions = (int)f;
+        params.width = w;
+        params.probes = (int)pr;
+        params.seed = seed;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        LSH<D> lsh(params);
+        lsh.build(nuclei);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::vector<int> nearest = lsh.findNearestBatch(spots, maxDist);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        double buildMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        double queryMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+        size_t hit = 0, labelHit = 0;
+        for (size_t i = 0; i < spots.size(); ++i) {
+            if (nearest[i] == exact[i]) ++hit;
+            int id = nearest[i] < 0 ? -1 : nuclei.id[nearest[i]];
+            if (id == spots.nucleus_id[i]) ++labelHit;
         }
-        
-        return nearest;
+        double n = std::max(spots.size(), (size_t)1);
+        double qps = queryMs > 0 ? spots.size() / (queryMs / 1000.0) : 0.0;
+        const LSHParams& used = lsh.parameters();
+        out << used.numTables << ',' << used.numFunctions << ',' << used.width << ',' << used.probes << ','
+            << buildMs << ',' << queryMs << ',' << (long long)qps << ','
+            << hit / n << ',' << labelHit / n << '\n';
+        std::cout << "tables=" << used.numTables << " functions=" << used.numFunctions
+                  << " width=" << used.width << " probes=" << used.probes
+                  << "  recall=" << hit / n << "  queries/s=" << (long long)qps << std::endl;
     }
-};
 
-void printUsage() {
-    std::cout << "Usage: ./lsh --nuclei <nuclei_file> --spots <spots_file> --out <output_file>" << std::endl;
+    std::cout << "Sweep results saved to " << sweepFile << std::endl;
+    return 0;
 }
 
-std::vector<std::pair<int, int>> findNearestNucleiLSH(
-    const std::vector<Point>& nuclei,
-    const std::vector<Point>& spots) {
-    
-    // 构建LSH索引
-    LSH lsh;
-    for (const auto& nucleus : nuclei) {
-        lsh.insert(nucleus);
-    }
-    
-    std::vector<std::pair<int, int>> matches;
-    matches.reserve(spots.size());
-
-    // 对每个spot查找最近的nucleus
-    for (const auto& spot : spots) {
-        Point nearest = lsh.findNearest(spot);
-        matches.emplace_back(spot.id, nearest.id);
+// 建索引（或加载 --index）后整批或流式匹配，D 为数据维数
+template <int D>
+int run(const std::string& nucleiFile, const std::string& spotsFile, const std::string& outputFile,
+        const std::string& indexFile, size_t chunkRows, double maxDist,
+        const LSHParams& params) {
+    // 建索引，或从 --index 文件映射加载（计入总耗时）
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    IndexArray<int> ids;
+    LSH<D> index;
+    auto build = [&](const PointArray& nuclei) {
+        LSH<D> lsh(params);
+        lsh.build(nuclei);
+        return lsh;
+    };
+    if (!openIndex(indexFile, nucleiFile, D == 3 ? "lsh3d" : "lsh", index, ids, build)) return 1;
+    // 哈希函数来自索引文件，探测数是查询参数，仍以命令行为准
+    index.setProbes(params.probes);
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Index ready in " << elapsedMs(loadStart, buildEnd) << " ms" << std::endl;
+
+    if (chunkRows > 0) {
+        // 流式模式：只常驻 nucleus 索引，spots 分块读取、匹配并追加写出
+        size_t total = streamMatch(spotsFile, outputFile, chunkRows, [&](const PointArray& chunk) {
+            std::vector<int> nearest = index.findNearestBatch(chunk, maxDist);
+            indicesToIds(ids, nearest);
+            return nearest;
+        });
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Streaming completed in " << elapsedMs(buildEnd, end) << " ms" << std::endl;
+        std::cout << "Total matches: " << total << std::endl;
+        std::cout << "Total time (load + match + write): " << elapsedMs(loadStart, end) << " ms" << std::endl;
+        return 0;
     }
 
-    return matches;
+    // 读取数据（单独计时，并计入总耗时）
+    auto spots = readPointArrayCSV(spotsFile, true);
+    auto loadEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Loading completed in " << elapsedMs(buildEnd, loadEnd) << " ms" << std::endl;
+
+    // 计时开始
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // 执行匹配
+    std::vector<int> nearest = index.findNearestBatch(spots, maxDist);
+    auto matches = toMatches(spots, nearest, ids);
+
+    // 计时结束
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // 输出执行时间
+    std::cout << "Matching completed in " << elapsedMs(start, end) << " ms" << std::endl;
+    std::cout << "Total matches: " << matches.size() << std::endl;
+
+    // 保存结果
+    writeResults(outputFile, matches);
+    auto writeEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Writing completed in " << elapsedMs(end, writeEnd) << " ms" << std::endl;
+    std::cout << "Total time (load + match + write): " << elapsedMs(loadStart, writeEnd) << " ms" << std::endl;
+
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
-    std::string nucleiFile, spotsFile, outputFile;
+    std::string nucleiFile, spotsFile, outputFile, indexFile, sweepFile;
+    size_t chunkRows = 0;
+    double maxDist = NO_MAX_DIST;
+    // 哈希参数：普通模式只取第一个值，扫描模式取所有组合
+    std::vector<double> tables{(double)NUM_HASH_TABLES};
+    std::vector<double> functions{(double)NUM_HASH_FUNCTIONS};
+    std::vector<double> widths{W};
+    std::vector<double> probes{0};
+    uint32_t seed = LSH_DEFAULT_SEED;
 
     // 解析命令行参数
     for (int i = 1; i < argc; i += 2) {
@@ -141,33 +159,69 @@ int main(int argc, char* argv[]) {
         if (arg == "--nuclei") nucleiFile = argv[i + 1];
         else if (arg == "--spots") spotsFile = argv[i + 1];
         else if (arg == "--out") outputFile = argv[i + 1];
+        else if (arg == "--index") indexFile = argv[i + 1];
+        else if (arg == "--chunk") chunkRows = std::stoul(argv[i + 1]);
+        else if (arg == "--max-dist") maxDist = std::stod(argv[i + 1]);
+        else if (arg == "--tables") tables = parseList(argv[i + 1]);
+        else if (arg == "--functions") functions = parseList(argv[i + 1]);
+        else if (arg == "--width") widths = parseList(argv[i + 1]);
+        else if (arg == "--probes") probes = parseList(argv[i + 1]);
+        else if (arg == "--seed") seed = (uint32_t)std::stoul(argv[i + 1]);
+        else if (arg == "--sweep") sweepFile = argv[i + 1];
     }
 
-    if (nucleiFile.empty() || spotsFile.empty() || outputFile.empty()) {
+    // 负数或 NaN 的 --max-dist 没有意义（平方后会被当成正数），直接报错
+    if (!validMaxDist(maxDist)) {
+        std::cerr << "Error: --max-dist must be a non-negative number" << std::endl;
         printUsage();
         return 1;
     }
 
-    // 读取数据
-    auto nuclei = readPointsFromCSV(nucleiFile);
-    auto spots = readPointsFromCSV(spotsFile, true);
-
-    // 计时开始
-    auto start = std::chrono::high_resolution_clock::now();
-
-    // 执行匹配
-    auto matches = findNearestNucleiLSH(nuclei, spots);
+    if (tables.empty() || functions.empty() || widths.empty() || probes.empty()) {
+        printUsage();
+        return 1;
+    }
 
-    // 计时结束
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    // 桶宽 w <= 0 或 NaN 时 floor(x / w) 无意义（w = 0 还会把 inf 转成整数），探测数不能为负；
+    // 扫描列表中的每个值都要检查
+    for (double w : widths) {
+        if (!(w > 0)) {
+            std::cerr << "Error: --width must be a positive number" << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+    for (double pr : probes) {
+        if (!(pr >= 0)) {
+            std::cerr << "Error: --probes must be a non-negative number" << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
 
-    // 输出执行时间
-    std::cout << "Matching completed in " << duration.count() << " ms" << std::endl;
-    std::cout << "Total matches: " << matches.size() << std::endl;
+    if (!sweepFile.empty() && !nucleiFile.empty() && !spotsFile.empty()) {
+        int dims = inputDimensions(nucleiFile, spotsFile);
+        if (dims == 0) return 1;
+        if (dims == 3) return runSweep<3>(nucleiFile, spotsFile, sweepFile, tables, functions, widths, probes, seed, maxDist);
+        return runSweep<2>(nucleiFile, spotsFile, sweepFile, tables, functions, widths, probes, seed, maxDist);
+    }
 
-    // 保存结果
-    writeResults(outputFile, matches);
+    // 已有索引文件时可以不给 nuclei
+    if ((nucleiFile.empty() && !fileExists(indexFile)) || spotsFile.empty() || outputFile.empty()) {
+        printUsage();
+        return 1;
+    }
 
-    return 0;
-} 
\ No newline at end of file
+    LSHParams params;
+    params.numTables = (int)tables[0];
+    params.numFunctions = (int)functions[0];
+    params.width = widths[0];
+    params.probes = (int)probes[0];
+    params.seed = seed;
+
+    // 维数由表头决定：第 4 列为 z 时按 3D 匹配
+    int dims = inputDimensions(nucleiFile, spotsFile);
+    if (dims == 0) return 1;
+    if (dims == 3) return run<3>(nucleiFile, spotsFile, outputFile, indexFile, chunkRows, maxDist, params);
+    return run<2>(nucleiFile, spotsFile, outputFile, indexFile, chunkRows, maxDist, params);
+}
@@ -0,0 +1,441 @@
+#ifndef LSH_H
+#define LSH_H
+
+#include "utils.h"
+#include "index_io.h"
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <functional>
+
+// LSH默认参数
+const int NUM_HASH_TABLES = 10;  // 哈希表数量
+const int NUM_HASH_FUNCTIONS = 4;  // 每个哈希表的哈希函数数量
+const double W = 4.0;  // LSH的桶宽度
+const uint32_t LSH_DEFAULT_SEED = 2025;  // 哈希函数的随机种子
+// 多探测用 64 位掩码表示扰动集合，每个表的哈希函数数不超过 32
+const int MAX_HASH_FUNCTIONS = 32;
+
+// 每个线程一次领取的查询数
+const size_t LSH_QUERY_GRAIN = 1024;
+// 批量查询时提前多少个查询预取其起始桶
+const size_t LSH_PREFETCH_DISTANCE = 4;
+
+// 运行时可调的 LSH 参数
+struct LSHParams {
+    int numTables = NUM_HASH_TABLES;
+    int numFunctions = NUM_HASH_FUNCTIONS;
+    double width = W;
+    int probes = 0;  // 每个表在精确桶之外额外探测的相邻桶数
+    uint32_t seed = LSH_DEFAULT_SEED;
+};
+
+// LSH哈希函数：D 维随机投影（2 或 3）
+template <int D>
+class LSHFunction {
+private:
+    double a[D];  // 随机投影向量
+    double b;  // 随机偏移
+    double w;  // 桶宽度
+    
+public:
+    LSHFunction(std::mt19937& gen, double width) : w(width) {
+        std::normal_distribution<> normal(0, 1);
+        
+        // 依次生成各维分量，2D 时与只有 a0/a1 的旧实现抽取顺序相同
+        for (int i = 0; i < D; ++i) a[i] = normal(gen);
+        std::uniform_real_distribution<> uniform(0, w);
+        b = uniform(gen);
+    }
+    
+    // 以桶宽为单位的投影位置：向下取整为桶号，小数部分为到桶下边界的相对距离
+    double position(const double* q) const {
+        double dot = a[0] * q[0];
+        for (int i = 1; i < D; ++i) dot += a[i] * q[i];
+        return (dot + b) / w;
+    }
+
+    int hash(const double* q) const {
+        return static_cast<int>(std::floor(position(q)));
+    }
+};
+
+// 查询时的去重位图、本次置位过的字以及多探测用的堆，每个线程各持一份
+struct LSHScratch {
+    // 多探测堆元素：扰动得分、扰动集合（排序后移动的位掩码）、集合中最大的位
+    struct Probe {
+        double score;
+        uint64_t mask;
+        int top;
+        bool operator>(const Probe& o) const { return score > o.score; }
+    };
+
+    std::vector<uint64_t> visited;
+    std::vector<int> touched;
+    std::vector<Probe> heap;
+
+    explicit LSHScratch(size_t n) : visited((n + 63) / 64, 0) {}
+};
+
+// 把一个哈希值混入 64 位键
+inline uint64_t hashCombine(uint64_t seed, int v) {
+    uint64_t h = (uint64_t)(uint32_t)v * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 32;
+    return seed ^ (h + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+}
+
+// LSH哈希表
+// 桶采用 CSR 布局：items 按键排序存放 nucleus 下标，bucketStart 记录每个桶的起点；
+// 键到桶编号的映射用开放寻址表 slotKeys/slotBucket 完成，查询不分配内存、不拷贝点。
+template <int D>
+class LSHTable {
+private:
+    IndexArray<LSHFunction<D>> hashFunctions;
+    IndexArray<uint64_t> slotKeys;
+    IndexArray<int> slotBucket;  // -1 表示空槽
+    uint64_t slotMask = 0;
+    IndexArray<int> bucketStart;
+    IndexArray<int> items;
+    
+    uint64_t keyOf(const int* h) const {
+        uint64_t key = 0;
+        for (size_t i = 0; i < hashFunctions.size(); ++i) {
+            key = hashCombine(key, h[i]);
+        }
+        return key;
+    }
+
+    uint64_t getHashKey(const double* q) const {
+        int h[MAX_HASH_FUNCTIONS];
+        for (size_t i = 0; i < hashFunctions.size(); ++i) {
+            h[i] = hashFunctions[i].hash(q);
+        }
+        return keyOf(h);
+    }
+
+    // 查找键所在的槽：命中返回该槽，否则返回应插入的空槽
+    size_t findSlot(uint64_t key) const {
+        size_t slot = (size_t)((key ^ (key >> 29)) & slotMask);
+        while (slotBucket[slot] >= 0 && slotKeys[slot] != key) {
+            slot = (slot + 1) & slotMask;
+        }
+        return slot;
+    }
+
+    // 返回键对应桶的 nucleus 下标区间 [first, last)，桶不存在时为空区间
+    std::pair<const int*, const int*> bucket(uint64_t key) const {
+        if (items.empty()) return std::make_pair(nullptr, nullptr);
+        int b = slotBucket[findSlot(key)];
+        if (b < 0) return std::make_pair(nullptr, nullptr);
+        const int* base = items.data();
+        return std::make_pair(base + bucketStart[b], base + bucketStart[b + 1]);
+    }
+    
+public:
+    LSHTable() = default;
+
+    LSHTable(std::mt19937& gen, const LSHParams& params) {
+        std::vector<LSHFunction<D>> functions;
+        for (int i = 0; i < params.numFunctions; ++i) {
+            functions.emplace_back(gen, params.width);
+        }
+        hashFunctions = std::move(functions);
+    }
+    
+    void build(const PointArray& points) {
+        size_t n = points.size();
+        // 按 (键, 下标) 排序，桶内保持插入顺序
+        std::vector<std::pair<uint64_t, int>> keyed(n);
+        double q[D];
+        for (size_t i = 0; i < n; ++i) {
+            points.point<D>(i, q);
+            keyed[i] = std::make_pair(getHashKey(q), (int)i);
+        }
+        std::sort(keyed.begin(), keyed.end());
+
+        size_t capacity = 2;
+        while (capacity < 2 * n) capacity *= 2;
+        slotMask = capacity - 1;
+        std::vector<uint64_t> keys(capacity, 0);
+        std::vector<int> slots(capacity, -1);
+        std::vector<int> starts;
+        std::vector<int> members(n);
+        for (size_t i = 0; i < n; ++i) {
+            if (i == 0 || keyed[i].first != keyed[i - 1].first) {
+                size_t slot = (size_t)((keyed[i].first ^ (keyed[i].first >> 29)) & slotMask);
+                while (slots[slot] >= 0) slot = (slot + 1) & slotMask;
+                keys[slot] = keyed[i].first;
+                slots[slot] = (int)starts.size();
+                starts.push_back((int)i);
+            }
+            members[i] = keyed[i].second;
+        }
+        starts.push_back((int)n);
+        slotKeys = std::move(keys);
+        slotBucket = std::move(slots);
+        bucketStart = std::move(starts);
+        items = std::move(members);
+    }
+
+    void save(IndexWriter& out) const {
+        out.value(slotMask);
+        out.array(hashFunctions);
+        out.array(slotKeys);
+        out.array(slotBucket);
+        out.array(bucketStart);
+        out.array(items);
+    }
+    void load(IndexReader& in) {
+        slotMask = in.value<uint64_t>();
+        in.array(hashFunctions);
+        in.array(slotKeys);
+        in.array(slotBucket);
+        in.array(bucketStart);
+        in.array(items);
+        // 槽数组长度必须是 slotMask + 1，函数数不超过上限
+        if (hashFunctions.size() > (size_t)MAX_HASH_FUNCTIONS ||
+            (!items.empty() && slotBucket.size() != slotMask + 1)) {
+            in.fail();
+        }
+    }
+    
+    // 返回查询点所在桶的 nucleus 下标区间 [first, last)
+    std::pair<const int*, const int*> query(const double* q) const {
+        return bucket(getHashKey(q));
+    }
+
+    // 预取查询点所在桶在开放寻址表中的槽
+    void prefetch(const double* q) const {
+        if (items.empty()) return;
+        uint64_t key = getHashKey(q);
+        size_t slot = (size_t)((key ^ (key >> 29)) & slotMask);
+        prefetchRead(&slotKeys[slot]);
+        prefetchRead(&slotBucket[slot]);
+    }
+
+    // 多探测（Lv et al., 2007）：先访问查询点所在的桶，再按扰动得分从小到大访问至多 probes 个相邻桶。
+    // 第 i 个函数向下或向上移一格的代价是查询点到该侧桶边界的距离平方（以桶宽为单位）；
+    // 2M 个单步移动按代价排序，扰动集合用排序位置的位掩码表示，从 {0} 出发经
+    // shift（最大位换成下一位）与 expand（追加下一位）生成，保证按总代价非降序出堆。
+    // 同一函数同时上下移动的集合无效，跳过但仍继续扩展。
+    template <typename Visit>
+    void probe(const double* q, int probes, LSHScratch& scratch, Visit visit) const {
+        const int m = (int)hashFunctions.size();
+        int h[MAX_HASH_FUNCTIONS];
+        double frac[MAX_HASH_FUNCTIONS];
+        for (int i = 0; i < m; ++i) {
+            double pos = hashFunctions[i].position(q);
+            double fl = std::floor(pos);
+            h[i] = (int)fl;
+            frac[i] = pos - fl;
+        }
+        visit(bucket(keyOf(h)));
+        if (probes <= 0 || m == 0) return;
+
+        // move = 函数编号 * 2 + 方向（0 向下，1 向上），按代价插入排序
+        int moves[2 * MAX_HASH_FUNCTIONS];
+        double cost[2 * MAX_HASH_FUNCTIONS];
+        int numMoves = 0;
+        for (int i = 0; i < m; ++i) {
+            for (int dir = 0; dir < 2; ++dir) {
+                double d = dir == 0 ? frac[i] : 1.0 - frac[i];
+                int j = numMoves++;
+                while (j > 0 && cost[j - 1] > d * d) {
+                    moves[j] = moves[j - 1];
+                    cost[j] = cost[j - 1];
+                    --j;
+                }
+                moves[j] = i * 2 + dir;
+                cost[j] = d * d;
+            }
+        }
+
+        std::vector<LSHScratch::Probe>& heap = scratch.heap;
+        auto push = [&](double score, uint64_t mask, int top) {
+            heap.push_back(LSHScratch::Probe{score, mask, top});
+            std::push_heap(heap.begin(), heap.end(), std::greater<LSHScratch::Probe>());
+        };
+        heap.clear();
+        push(cost[0], 1, 0);
+        int done = 0;
+        while (done < probes && !heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<LSHScratch::Probe>());
+            LSHScratch::Probe cur = heap.back();
+            heap.pop_back();
+            if (cur.top + 1 < numMoves) {
+                uint64_t next = 1ULL << (cur.top + 1);
+                push(cur.score - cost[cur.top] + cost[cur.top + 1],
+                     (cur.mask ^ (1ULL << cur.top)) | next, cur.top + 1);
+                push(cur.score + cost[cur.top + 1], cur.mask | next, cur.top + 1);
+            }
+
+            int hp[MAX_HASH_FUNCTIONS];
+            std::copy(h, h + m, hp);
+            uint64_t used = 0;
+            bool valid = true;
+            for (int j = 0; j <= cur.top && valid; ++j) {
+                if (!(cur.mask >> j & 1)) continue;
+                int f = moves[j] >> 1;
+                if (used >> f & 1) valid = false;
+                used |= 1ULL << f;
+                hp[f] += (moves[j] & 1) ? 1 : -1;
+            }
+            if (!valid) continue;
+            visit(bucket(keyOf(hp)));
+            ++done;
+        }
+    }
+};
+
+// 维数 D（2 或 3）为模板参数，哈希投影与距离计算按维数在编译期展开
+template <int D = 2>
+class LSH {
+private:
+    LSHParams params;
+    std::vector<LSHTable<D>> hashTables;
+    // nucleus 各维坐标的副本，索引文件中与哈希表一起保存
+    IndexArray<double> coords[D];
+    
+public:
+    // 哈希函数全部由 params.seed 初始化的同一个 mt19937 依次生成，同样的参数得到同样的索引
+    explicit LSH(const LSHParams& p = LSHParams()) : params(p) {
+        params.numTables = std::max(params.numTables, 1);
+        params.numFunctions = std::min(std::max(params.numFunctions, 1), MAX_HASH_FUNCTIONS);
+        std::mt19937 gen(params.seed);
+        for (int i = 0; i < params.numTables; ++i) {
+            hashTables.emplace_back(gen, params);
+        }
+    }
+    
+    void build(const PointArray& nuclei) {
+        for (int a = 0; a < D; ++a) coords[a] = nuclei.coord(a);
+        for (auto& table : hashTables) {
+            table.build(nuclei);
+        }
+    }
+
+    const LSHParams& parameters() const { return params; }
+
+    // 探测数只影响查询，加载已有索引后仍可调整
+    void setProbes(int probes) { params.probes = probes; }
+
+    // 参数、表数、各表依次写出；读回后哈希函数直接来自文件，不再由种子重新生成
+    void save(IndexWriter& out) const {
+        out.value(params);
+        out.value<uint32_t>((uint32_t)hashTables.size());
+        for (const auto& table : hashTables) {
+            table.save(out);
+        }
+        for (int a = 0; a < D; ++a) out.array(coords[a]);
+    }
+    void load(IndexReader& in) {
+        params = in.value<LSHParams>();
+        uint32_t numTables = in.value<uint32_t>();
+        hashTables.clear();
+        hashTables.resize(in.good() ? numTables : 0);
+        for (auto& table : hashTables) {
+            table.load(in);
+        }
+        for (int a = 0; a < D; ++a) in.array(coords[a]);
+    }
+    
+    // 返回最近 nucleus 的下标，所有探测到的桶中都没有候选时返回 -1。
+    // 候选按表序检查，每个表先查精确桶再查多探测的相邻桶，桶内按插入顺序；
+    // 同一 nucleus 出现在多个桶中时只计算一次距离。
+    // bound2 为初始平方距离上界，超出的候选不予匹配
+    int findNearest(const double* q, double bound2, LSHScratch& scratch) const {
+        int nearest = -1;
+        double minD2 = bound2;
+        const double* c[D];
+        for (int a = 0; a < D; ++a) c[a] = coords[a].data();
+        std::vector<uint64_t>& visited = scratch.visited;
+        auto check = [&](std::pair<const int*, const int*> bucket) {
+            for (const int* it = bucket.first; it != bucket.second; ++it) {
+                int idx = *it;
+                uint64_t bit = 1ULL << (idx & 63);
+                if (visited[idx >> 6] & bit) continue;
+                if (visited[idx >> 6] == 0) scratch.touched.push_back(idx >> 6);
+                visited[idx >> 6] |= bit;
+                double diff = q[0] - c[0][idx];
+                double d2 = diff * diff;
+                for (int a = 1; a < D; ++a) {
+                    diff = q[a] - c[a][idx];
+                    d2 += diff * diff;
+                }
+                if (d2 < minD2) {
+                    minD2 = d2;
+                    nearest = idx;
+                }
+            }
+        };
+        
+        // 在所有哈希表中查找候选点
+        for (const auto& table : hashTables) {
+            table.probe(q, params.probes, scratch, check);
+        }
+        // 只清理本次置过位的字
+        for (int w : scratch.touched) {
+            visited[w] = 0;
+        }
+        scratch.touched.clear();
+        
+        return nearest;
+    }
+
+    int findNearest(double qx, double qy, double bound2, LSHScratch& scratch) const {
+        static_assert(D == 2, "use findNearest(const double*, ...) for 3D indexes");
+        const double q[2] = {qx, qy};
+        return findNearest(q, bound2, scratch);
+    }
+
+    // 批量查询：按 Morton 码顺序多线程分块查询，空间上相邻的查询连续命中同一批桶；
+    // 查询第 k 个点时预取第 k + LSH_PREFETCH_DISTANCE 个点在第一个表中的槽，
+    // 每块使用独立的去重位图，结果按原始顺序写回
+    std::vector<int> findNearestBatch(const PointArray& queries, double maxDist = NO_MAX_DIST) const {
+        std::vector<int> result(queries.size());
+        const double bound2 = searchBound2(maxDist);
+        MortonBatch batch(queries);
+        parallelFor(batch.size(), LSH_QUERY_GRAIN, [&](size_t begin, size_t end) {
+            LSHScratch scratch(coords[0].size());
+            double q[D];
+            for (size_t k = begin; k < end; ++k) {
+                if (k + LSH_PREFETCH_DISTANCE < end) {
+                    batch.point<D>(k + LSH_PREFETCH_DISTANCE, q);
+                    hashTables[0].prefetch(q);
+                }
+                batch.point<D>(k, q);
+                result[batch.order[k]] = findNearest(q, bound2, scratch);
+            }
+        });
+        return result;
+    }
+};
+
+inline std::vector<std::pair<int, int>> findNearestNucleiLSH(
+    const PointArray& nuclei,
+    const PointArray& spots,
+    double maxDist = NO_MAX_DIST,
+    const LSHParams& params = LSHParams()) {
+    
+    // 构建LSH索引，整批查询每个spot的最近nucleus
+    std::vector<int> nearest;
+    if (nuclei.dims == 3) {
+        LSH<3> lsh(params);
+        lsh.build(nuclei);
+        nearest = lsh.findNearestBatch(spots, maxDist);
+    } else {
+        LSH<2> lsh(params);
+        lsh.build(nuclei);
+        nearest = lsh.findNearestBatch(spots, maxDist);
+    }
+
+    std::vector<std::pair<int, int>> matches(spots.size());
+    for (size_t i = 0; i < spots.size(); ++i) {
+        matches[i] = std::make_pair(spots.id[i], nearest[i] < 0 ? -1 : nuclei.id[nearest[i]]);
+    }
+
+    return matches;
+}
+
+#endif // LSH_H
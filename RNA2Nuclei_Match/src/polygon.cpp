@@ -0,0 +1,99 @@
+#include "polygon.h"
+#include <chrono>
+
+void printUsage() {
+    std::cout << "Usage: ./polygon --nuclei <nuclei_file> --spots <spots_file> --out <output_file> "
+                 "[--polygons <polygons_file>] [--index <index_file>] [--chunk <rows>] [--max-dist <d>]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string nucleiFile, spotsFile, outputFile, indexFile, polygonsFile;
+    size_t chunkRows = 0;
+    double maxDist = NO_MAX_DIST;
+
+    // 解析命令行参数
+    for (int i = 1; i < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--nuclei") nucleiFile = argv[i + 1];
+        else if (arg == "--spots") spotsFile = argv[i + 1];
+        else if (arg == "--out") outputFile = argv[i + 1];
+        else if (arg == "--index") indexFile = argv[i + 1];
+        else if (arg == "--polygons") polygonsFile = argv[i + 1];
+        else if (arg == "--chunk") chunkRows = std::stoul(argv[i + 1]);
+        else if (arg == "--max-dist") maxDist = std::stod(argv[i + 1]);
+    }
+
+    // 负数或 NaN 的 --max-dist 没有意义（平方后会被当成正数），直接报错
+    if (!validMaxDist(maxDist)) {
+        std::cerr << "Error: --max-dist must be a non-negative number" << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    // 已有索引文件时可以不给 nuclei
+    if ((nucleiFile.empty() && !fileExists(indexFile)) || spotsFile.empty() || outputFile.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    // 只支持 2D 数据，3D 数据请使用 brute_force、kdtree 或 lsh
+    int dims = inputDimensions(nucleiFile, spotsFile);
+    if (dims == 0) return 1;
+    if (dims != 2) {
+        std::cerr << "Error: polygon supports 2D data only (use brute_force, kdtree or lsh for 3D)" << std::endl;
+        return 1;
+    }
+
+    // 建索引，或从 --index 文件映射加载（计入总耗时）
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    IndexArray<int> ids;
+    NucleusShapeIndex index;
+    auto build = [&](const PointArray& nuclei) {
+        return NucleusShapeIndex(readNucleusShapes(nuclei, nucleiFile, polygonsFile));
+    };
+    if (!openIndex(indexFile, nucleiFile, "polygon", index, ids, build)) return 1;
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Index ready in " << elapsedMs(loadStart, buildEnd) << " ms" << std::endl;
+
+    if (chunkRows > 0) {
+        // 流式模式：只常驻 nucleus 索引，spots 分块读取、匹配并追加写出
+        size_t total = streamMatch(spotsFile, outputFile, chunkRows, [&](const PointArray& chunk) {
+            std::vector<int> nearest = index.findNearestBatch(chunk, maxDist);
+            indicesToIds(ids, nearest);
+            return nearest;
+        });
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Streaming completed in " << elapsedMs(buildEnd, end) << " ms" << std::endl;
+        std::cout << "Total matches: " << total << std::endl;
+        std::cout << "Total time (load + match + write): " << elapsedMs(loadStart, end) << " ms" << std::endl;
+        return 0;
+    }
+
+    // 读取数据（单独计时，并计入总耗时）
+    auto spots = readPointArrayCSV(spotsFile, true);
+    auto loadEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Loading completed in " << elapsedMs(buildEnd, loadEnd) << " ms" << std::endl;
+
+    // 计时开始
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // 执行匹配
+    std::vector<int> nearest = index.findNearestBatch(spots, maxDist);
+    auto matches = toMatches(spots, nearest, ids);
+
+    // 计时结束
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // 输出执行时间
+    std::cout << "Matching completed in " << elapsedMs(start, end) << " ms" << std::endl;
+    std::cout << "Total matches: " << matches.size() << std::endl;
+
+    // 保存结果
+    writeResults(outputFile, matches);
+    auto writeEnd = std::chrono::high_resolution_clock::now();
+    std::cout << "Writing completed in " << elapsedMs(end, writeEnd) << " ms" << std::endl;
+    std::cout << "Total time (load + match + write): " << elapsedMs(loadStart, writeEnd) << " ms" << std::endl;
+
+    return 0;
+}
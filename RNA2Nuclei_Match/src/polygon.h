@@ -0,0 +1,358 @@
+#ifndef POLYGON_H
+#define POLYGON_H
+
+#include "utils.h"
+#include "index_io.h"
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+// 每个格子期望覆盖的 nucleus 包围盒数量
+const double SHAPE_NUCLEI_PER_CELL = 2.0;
+// 每个线程一次领取的查询数
+const size_t SHAPE_QUERY_GRAIN = 1024;
+
+// nucleus 形状：分割多边形（polyStart[k]..polyStart[k+1] 为第 k 个 nucleus 的顶点区间），
+// 没有多边形的 nucleus 视为以质心为圆心、radius[k] 为半径的圆（半径为 0 即退化为质心）。
+struct NucleusShapes {
+    IndexArray<double> cx, cy, radius;
+    IndexArray<int> polyStart;
+    IndexArray<double> vx, vy;
+
+    size_t size() const { return cx.size(); }
+    bool hasPolygon(size_t k) const {
+        return !polyStart.empty() && polyStart[k + 1] - polyStart[k] >= 3;
+    }
+
+    void save(IndexWriter& out) const {
+        out.array(cx);
+        out.array(cy);
+        out.array(radius);
+        out.array(polyStart);
+        out.array(vx);
+        out.array(vy);
+    }
+    void load(IndexReader& in) {
+        in.array(cx);
+        in.array(cy);
+        in.array(radius);
+        in.array(polyStart);
+        in.array(vx);
+        in.array(vy);
+    }
+};
+
+// 读取 nucleus 形状：nuclei 文件中可选的 radius 列，以及可选的多边形文件
+// （每行一个顶点 nucleus_id,x,y，同一 nucleus 的顶点按边界顺序连续给出）
+inline NucleusShapes readNucleusShapes(const PointArray& nuclei, const std::string& nucleiFile,
+                                       const std::string& polygonsFile) {
+    NucleusShapes shapes;
+    size_t n = nuclei.size();
+    shapes.cx = nuclei.x;
+    shapes.cy = nuclei.y;
+    std::vector<double> radius = readDoubleColumnCSV(nucleiFile, "radius");
+    if (radius.size() != n) radius.assign(n, 0.0);
+    shapes.radius = std::move(radius);
+
+    if (polygonsFile.empty()) return shapes;
+    PointArray vertices = readPointArrayCSV(polygonsFile);
+    std::unordered_map<int, int> indexOf;
+    indexOf.reserve(n);
+    for (size_t k = 0; k < n; ++k) indexOf.emplace(nuclei.id[k], (int)k);
+
+    // 计数 -> 前缀和 -> 回填，按 nucleus 下标组织成 CSR
+    std::vector<int> owner(vertices.size(), -1);
+    std::vector<int> polyStart(n + 1, 0);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        auto it = indexOf.find(vertices.id[i]);
+        if (it == indexOf.end()) continue;
+        owner[i] = it->second;
+        polyStart[it->second + 1]++;
+    }
+    for (size_t k = 1; k <= n; ++k) polyStart[k] += polyStart[k - 1];
+    std::vector<int> fill(polyStart.begin(), polyStart.end() - 1);
+    std::vector<double> vx(polyStart[n]), vy(polyStart[n]);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        if (owner[i] < 0) continue;
+        int pos = fill[owner[i]]++;
+        vx[pos] = vertices.x[i];
+        vy[pos] = vertices.y[i];
+    }
+    shapes.polyStart = std::move(polyStart);
+    shapes.vx = std::move(vx);
+    shapes.vy = std::move(vy);
+    return shapes;
+}
+
+// 形状感知的匹配索引
+// 先按包含关系分配（spot 落在某个 nucleus 内部），否则分配给边界最近的 nucleus。
+// 统一用"到边界的有向距离"打分：内部为负（越深越小），外部为正，取最小者，
+// 因此包含关系天然优先；同分时取下标最小者。
+// 索引是覆盖所有包围盒的均匀网格，每个 nucleus 登记到其包围盒覆盖的所有格子（CSR 布局）。
+class NucleusShapeIndex {
+private:
+    NucleusShapes shapes;
+    IndexArray<double> boxMinX, boxMinY, boxMaxX, boxMaxY;
+    double minX = 0, minY = 0;
+    double cellSize = 1.0;
+    int gridWidth = 0, gridHeight = 0;
+    IndexArray<int> cellStart;
+    IndexArray<int> items;
+
+    inline int cellX(double x) const {
+        int gx = (int)std::floor((x - minX) / cellSize);
+        return std::min(std::max(gx, 0), gridWidth - 1);
+    }
+    inline int cellY(double y) const {
+        int gy = (int)std::floor((y - minY) / cellSize);
+        return std::min(std::max(gy, 0), gridHeight - 1);
+    }
+
+    // 查询点到格子 (gx, gy) 的最小距离
+    inline double cellMinDist(double qx, double qy, int gx, int gy) const {
+        double x0 = minX + gx * cellSize;
+        double y0 = minY + gy * cellSize;
+        double dx = qx < x0 ? x0 - qx : (qx > x0 + cellSize ? qx - x0 - cellSize : 0.0);
+        double dy = qy < y0 ? y0 - qy : (qy > y0 + cellSize ? qy - y0 - cellSize : 0.0);
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    // 查询点到第 k 个包围盒的最小距离，是到该形状边界距离的下界（点在盒外时）
+    inline double boxMinDist(double qx, double qy, int k) const {
+        double dx = qx < boxMinX[k] ? boxMinX[k] - qx : std::max(qx - boxMaxX[k], 0.0);
+        double dy = qy < boxMinY[k] ? boxMinY[k] - qy : std::max(qy - boxMaxY[k], 0.0);
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    // 查询点到第 k 个形状边界的有向距离，内部为负
+    double signedDistance(double qx, double qy, int k) const {
+        if (!shapes.hasPolygon(k)) {
+            double dx = qx - shapes.cx[k];
+            double dy = qy - shapes.cy[k];
+            return std::sqrt(dx * dx + dy * dy) - shapes.radius[k];
+        }
+        // 逐边求点到线段的最短距离，同时用射线法判断包含
+        bool inside = false;
+        double best2 = std::numeric_limits<double>::infinity();
+        int begin = shapes.polyStart[k], end = shapes.polyStart[k + 1];
+        for (int i = begin, j = end - 1; i < end; j = i++) {
+            double ax = shapes.vx[j], ay = shapes.vy[j];
+            double bx = shapes.vx[i], by = shapes.vy[i];
+            if ((by > qy) != (ay > qy) && qx < ax + (bx - ax) * (qy - ay) / (by - ay)) {
+                inside = !inside;
+            }
+            double ex = bx - ax, ey = by - ay;
+            double len2 = ex * ex + ey * ey;
+            double t = len2 > 0 ? ((qx - ax) * ex + (qy - ay) * ey) / len2 : 0.0;
+            t = std::min(std::max(t, 0.0), 1.0);
+            double dx = qx - (ax + t * ex);
+            double dy = qy - (ay + t * ey);
+            best2 = std::min(best2, dx * dx + dy * dy);
+        }
+        double d = std::sqrt(best2);
+        return inside ? -d : d;
+    }
+
+    // 扫描一个格子，先用包围盒距离剪枝，再计算精确的有向距离
+    inline void scanCell(int c, double qx, double qy, double& bestDist, int& bestIdx) const {
+        for (int i = cellStart[c]; i < cellStart[c + 1]; ++i) {
+            int k = items[i];
+            // 查询点在包围盒内时下界为 0，不能据此剪掉可能包含查询点的 nucleus
+            double lower = boxMinDist(qx, qy, k);
+            if (lower > 0 && lower > bestDist) continue;
+            double d = signedDistance(qx, qy, k);
+            if (d < bestDist || (d == bestDist && k < bestIdx)) {
+                bestDist = d;
+                bestIdx = k;
+            }
+        }
+    }
+
+public:
+    NucleusShapeIndex() = default;
+
+    // 形状随索引一起保存，按值持有
+    NucleusShapeIndex(NucleusShapes s) : shapes(std::move(s)) {
+        size_t n = shapes.size();
+        if (n == 0) return;
+
+        // 每个 nucleus 的包围盒
+        std::vector<double> lowX(n), lowY(n), highX(n), highY(n);
+        double sumExtent = 0.0;
+        for (size_t k = 0; k < n; ++k) {
+            if (shapes.hasPolygon(k)) {
+                auto b = shapes.vx.begin() + shapes.polyStart[k];
+                auto e = shapes.vx.begin() + shapes.polyStart[k + 1];
+                lowX[k] = *std::min_element(b, e);
+                highX[k] = *std::max_element(b, e);
+                b = shapes.vy.begin() + shapes.polyStart[k];
+                e = shapes.vy.begin() + shapes.polyStart[k + 1];
+                lowY[k] = *std::min_element(b, e);
+                highY[k] = *std::max_element(b, e);
+            } else {
+                double r = std::max(shapes.radius[k], 0.0);
+                lowX[k] = shapes.cx[k] - r;
+                highX[k] = shapes.cx[k] + r;
+                lowY[k] = shapes.cy[k] - r;
+                highY[k] = shapes.cy[k] + r;
+            }
+            sumExtent += std::max(highX[k] - lowX[k], highY[k] - lowY[k]);
+        }
+        minX = *std::min_element(lowX.begin(), lowX.end());
+        minY = *std::min_element(lowY.begin(), lowY.end());
+        double maxX = *std::max_element(highX.begin(), highX.end());
+        double maxY = *std::max_element(highY.begin(), highY.end());
+        double spanX = std::max(maxX - minX, 1e-9);
+        double spanY = std::max(maxY - minY, 1e-9);
+
+        // 格子边长取密度估计与平均包围盒尺寸中的较大者，避免大 nucleus 登记到过多格子
+        cellSize = std::sqrt(spanX * spanY * SHAPE_NUCLEI_PER_CELL / n);
+        cellSize = std::max(cellSize, sumExtent / n);
+        cellSize = std::max(cellSize, std::max(spanX, spanY) / 4096.0);
+        gridWidth = (int)(spanX / cellSize) + 1;
+        gridHeight = (int)(spanY / cellSize) + 1;
+
+        // 计数 -> 前缀和 -> 回填，每个 nucleus 登记到包围盒覆盖的全部格子
+        std::vector<int> starts((size_t)gridWidth * gridHeight + 1, 0);
+        std::vector<int> members;
+        for (int pass = 0; pass < 2; ++pass) {
+            std::vector<int> fill;
+            if (pass == 1) {
+                for (size_t c = 1; c < starts.size(); ++c) starts[c] += starts[c - 1];
+                members.resize(starts.back());
+                fill.assign(starts.begin(), starts.end() - 1);
+            }
+            for (size_t k = 0; k < n; ++k) {
+                for (int gy = cellY(lowY[k]); gy <= cellY(highY[k]); ++gy) {
+                    for (int gx = cellX(lowX[k]); gx <= cellX(highX[k]); ++gx) {
+                        int c = gy * gridWidth + gx;
+                        if (pass == 0) starts[c + 1]++;
+                        else members[fill[c]++] = (int)k;
+                    }
+                }
+            }
+        }
+        boxMinX = std::move(lowX);
+        boxMinY = std::move(lowY);
+        boxMaxX = std::move(highX);
+        boxMaxY = std::move(highY);
+        cellStart = std::move(starts);
+        items = std::move(members);
+    }
+
+    void save(IndexWriter& out) const {
+        shapes.save(out);
+        out.value(minX);
+        out.value(minY);
+        out.value(cellSize);
+        out.value(gridWidth);
+        out.value(gridHeight);
+        out.array(boxMinX);
+        out.array(boxMinY);
+        out.array(boxMaxX);
+        out.array(boxMaxY);
+        out.array(cellStart);
+        out.array(items);
+    }
+    void load(IndexReader& in) {
+        shapes.load(in);
+        minX = in.value<double>();
+        minY = in.value<double>();
+        cellSize = in.value<double>();
+        gridWidth = in.value<int>();
+        gridHeight = in.value<int>();
+        in.array(boxMinX);
+        in.array(boxMinY);
+        in.array(boxMaxX);
+        in.array(boxMaxY);
+        in.array(cellStart);
+        in.array(items);
+    }
+
+    // 包含查询点的 nucleus 都登记在查询点所在格子里，先扫描该格子；
+    // 若未被包含，再从该格子向外逐圈搜索边界最近者，下一圈的距离下界超过当前最优时结束。
+    // maxDist 为到边界距离的上界（包含关系不受限制）；返回 nucleus 下标，未分配时返回 -1。
+    int findNearest(double qx, double qy, double maxDist) const {
+        int bestIdx = -1;
+        double bestDist = std::nextafter(maxDist, std::numeric_limits<double>::infinity());
+        if (shapes.size() == 0) return bestIdx;
+
+        // 查询点离整个网格都超出上界，直接判为未分配
+        double ox = qx < minX ? minX - qx : std::max(qx - (minX + gridWidth * cellSize), 0.0);
+        double oy = qy < minY ? minY - qy : std::max(qy - (minY + gridHeight * cellSize), 0.0);
+        if (std::sqrt(ox * ox + oy * oy) > bestDist) return bestIdx;
+
+        int cx = cellX(qx);
+        int cy = cellY(qy);
+        scanCell(cy * gridWidth + cx, qx, qy, bestDist, bestIdx);
+        if (bestIdx >= 0 && bestDist <= 0) return bestIdx;
+
+        int maxRing = std::max(std::max(cx, gridWidth - 1 - cx), std::max(cy, gridHeight - 1 - cy));
+        for (int r = 1; r <= maxRing; ++r) {
+            // 与 grid.cpp 相同的两个下界：投影间隔与内圈正方形边界
+            double gap = (r - 1) * cellSize;
+            if (gap > bestDist) break;
+            double inner = std::min(std::min(qx - (minX + (cx - r + 1) * cellSize),
+                                             (minX + (cx + r) * cellSize) - qx),
+                                    std::min(qy - (minY + (cy - r + 1) * cellSize),
+                                             (minY + (cy + r) * cellSize) - qy));
+            if (inner > bestDist) break;
+
+            int x0 = cx - r, x1 = cx + r;
+            int y0 = cy - r, y1 = cy + r;
+            for (int gx = std::max(x0, 0); gx <= std::min(x1, gridWidth - 1); ++gx) {
+                // 上下两行
+                if (y0 >= 0 && cellMinDist(qx, qy, gx, y0) <= bestDist) {
+                    scanCell(y0 * gridWidth + gx, qx, qy, bestDist, bestIdx);
+                }
+                if (y1 < gridHeight && cellMinDist(qx, qy, gx, y1) <= bestDist) {
+                    scanCell(y1 * gridWidth + gx, qx, qy, bestDist, bestIdx);
+                }
+            }
+            for (int gy = std::max(y0 + 1, 0); gy <= std::min(y1 - 1, gridHeight - 1); ++gy) {
+                // 左右两列（不含角上已扫描的格子）
+                if (x0 >= 0 && cellMinDist(qx, qy, x0, gy) <= bestDist) {
+                    scanCell(gy * gridWidth + x0, qx, qy, bestDist, bestIdx);
+                }
+                if (x1 < gridWidth && cellMinDist(qx, qy, x1, gy) <= bestDist) {
+                    scanCell(gy * gridWidth + x1, qx, qy, bestDist, bestIdx);
+                }
+            }
+        }
+        return bestIdx;
+    }
+
+    // 批量查询：按 Morton 码顺序多线程查询，结果按原始顺序写回
+    std::vector<int> findNearestBatch(const PointArray& queries, double maxDist = NO_MAX_DIST) const {
+        std::vector<int> result(queries.size());
+        MortonBatch batch(queries);
+        parallelFor(batch.size(), SHAPE_QUERY_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                result[batch.order[k]] = findNearest(batch.xs[k], batch.ys[k], maxDist);
+            }
+        });
+        return result;
+    }
+};
+
+inline std::vector<std::pair<int, int>> findNearestNucleiShape(
+    const PointArray& nuclei,
+    const NucleusShapes& shapes,
+    const PointArray& spots,
+    double maxDist = NO_MAX_DIST) {
+
+    // 构建包围盒网格
+    NucleusShapeIndex index(shapes);
+
+    // 整批查询每个spot所属的nucleus
+    std::vector<int> nearest = index.findNearestBatch(spots, maxDist);
+
+    std::vector<std::pair<int, int>> matches(spots.size());
+    for (size_t i = 0; i < spots.size(); ++i) {
+        matches[i] = std::make_pair(spots.id[i], nearest[i] < 0 ? -1 : nuclei.id[nearest[i]]);
+    }
+
+    return matches;
+}
+
+#endif // POLYGON_H
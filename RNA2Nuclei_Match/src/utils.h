@@ -4,56 +4,466 @@
 #include <vector>
 #include <string>
 #include <fstream>
-#include <sstream>
 #include <cmath>
+#include <limits>
+#include <cstring>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-// 定义点结构
-struct Point {
-    int id;
-    double x, y;
-    int nucleus_id;  // 仅用于spots点的真实标签
+// 按列存放的点集（SoA），坐标连续存放便于向量化和分块访问。
+// 表头第 4 列为 z 时按 3D 读取（dims == 3），否则 z 为空。
+struct PointArray {
+    std::vector<int> id;
+    std::vector<double> x, y, z;
+    std::vector<int> nucleus_id;  // 仅用于spots点的真实标签
+    int dims = 2;
 
-    Point() : id(-1), x(0), y(0), nucleus_id(-1) {}
-    Point(int _id, double _x, double _y, int _nucleus_id = -1) 
-        : id(_id), x(_x), y(_y), nucleus_id(_nucleus_id) {}
+    size_t size() const { return id.size(); }
+
+    const std::vector<double>& coord(int axis) const { return axis == 0 ? x : (axis == 1 ? y : z); }
+
+    // 取第 i 个点的前 D 个坐标
+    template <int D>
+    void point(size_t i, double* q) const {
+        q[0] = x[i];
+        q[1] = y[i];
+        if constexpr (D == 3) q[2] = z[i];
+    }
+
+    // 把第 from 行搬到第 to 行，用于解析后剔除格式错误的行
+    void moveRow(size_t from, size_t to) {
+        id[to] = id[from];
+        x[to] = x[from];
+        y[to] = y[from];
+        if (!z.empty()) z[to] = z[from];
+        nucleus_id[to] = nucleus_id[from];
+    }
+
+    void resize(size_t n) {
+        id.resize(n);
+        x.resize(n);
+        y.resize(n);
+        z.resize(dims == 3 ? n : 0);
+        nucleus_id.resize(n);
+    }
 };
 
-// 计算两点之间的欧氏距离
-inline double distance(const Point& p1, const Point& p2) {
-    return std::sqrt((p1.x - p2.x) * (p1.x - p2.x) + 
-                     (p1.y - p2.y) * (p1.y - p2.y));
+// 不限制匹配距离
+const double NO_MAX_DIST = std::numeric_limits<double>::infinity();
+
+// --max-dist 须为非负数（可为 inf）；负数与 NaN 返回 false，由命令行入口报参数错误
+inline bool validMaxDist(double maxDist) {
+    return maxDist >= 0;
+}
+
+// 把 --max-dist（须已通过 validMaxDist）换算为搜索的初始平方距离上界。距离恰好等于 max-dist 的 nucleus 仍可匹配；
+// 超出上界的 spot 不分配 nucleus（输出 -1）。
+inline double searchBound2(double maxDist) {
+    if (!(maxDist < NO_MAX_DIST)) return std::numeric_limits<double>::max();
+    return std::nextafter(maxDist * maxDist, std::numeric_limits<double>::infinity());
+}
+
+// 两个时间点之间的毫秒数
+inline long long elapsedMs(std::chrono::high_resolution_clock::time_point start,
+                           std::chrono::high_resolution_clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+}
+
+// 工作线程数，默认使用全部硬件线程
+inline unsigned numWorkerThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// 将 [0, n) 按 grain 大小分块，由多个线程动态领取，func(begin, end) 处理一块
+template <typename Func>
+inline void parallelFor(size_t n, size_t grain, Func func) {
+    if (n == 0) return;
+    size_t numBlocks = (n + grain - 1) / grain;
+    size_t numThreads = std::min<size_t>(numWorkerThreads(), numBlocks);
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        size_t b;
+        while ((b = next.fetch_add(1)) < numBlocks) {
+            size_t begin = b * grain;
+            func(begin, std::min(n, begin + grain));
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < numThreads; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+// 把 16 位整数的各位间隔展开，用于拼接 Morton 码
+inline uint32_t spreadBits16(uint32_t v) {
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+// 把 10 位整数的各位间隔两位展开，用于拼接 3D Morton 码
+inline uint32_t spreadBits10(uint32_t v) {
+    v &= 0x3FF;
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+// 把一维坐标线性映射到 [0, cells] 的格子编号上：lo 返回最小值，函数返回缩放系数
+inline double mortonScale(const std::vector<double>& v, double& lo, double cells) {
+    lo = *std::min_element(v.begin(), v.end());
+    double hi = *std::max_element(v.begin(), v.end());
+    return hi > lo ? cells / (hi - lo) : 0.0;
+}
+
+// 按 32 位码排序返回下标：两趟 16 位基数排序（LSD，稳定），码相同的点保持原始顺序
+inline std::vector<uint32_t> sortByCode(const std::vector<uint32_t>& codes) {
+    size_t n = codes.size();
+    std::vector<uint32_t> order(n);
+    std::vector<uint32_t> tmp(n);
+    std::vector<size_t> count(1 << 16);
+    for (size_t i = 0; i < n; ++i) tmp[i] = (uint32_t)i;
+    for (int shift = 0; shift < 32; shift += 16) {
+        std::fill(count.begin(), count.end(), 0);
+        for (size_t i = 0; i < n; ++i) count[(codes[tmp[i]] >> shift) & 0xFFFF]++;
+        size_t sum = 0;
+        for (size_t& c : count) {
+            size_t k = c;
+            c = sum;
+            sum += k;
+        }
+        for (size_t i = 0; i < n; ++i) order[count[(codes[tmp[i]] >> shift) & 0xFFFF]++] = tmp[i];
+        if (shift == 0) tmp.swap(order);
+    }
+    return order;
+}
+
+// 按 Morton（Z 序）码对点排序，返回访问顺序。空间上相邻的查询排在一起，
+// 连续查询会落到索引的同一片区域，缓存命中率更高。2D 每轴 16 位，3D 每轴 10 位。
+inline std::vector<uint32_t> mortonOrder(const PointArray& points) {
+    size_t n = points.size();
+    if (n == 0) return std::vector<uint32_t>();
+    std::vector<uint32_t> codes(n);
+    double minX, minY, minZ;
+    if (points.dims == 3) {
+        double sx = mortonScale(points.x, minX, 1023.0);
+        double sy = mortonScale(points.y, minY, 1023.0);
+        double sz = mortonScale(points.z, minZ, 1023.0);
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t gx = (uint32_t)((points.x[i] - minX) * sx);
+            uint32_t gy = (uint32_t)((points.y[i] - minY) * sy);
+            uint32_t gz = (uint32_t)((points.z[i] - minZ) * sz);
+            codes[i] = spreadBits10(gx) | (spreadBits10(gy) << 1) | (spreadBits10(gz) << 2);
+        }
+    } else {
+        double sx = mortonScale(points.x, minX, 65535.0);
+        double sy = mortonScale(points.y, minY, 65535.0);
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t gx = (uint32_t)((points.x[i] - minX) * sx);
+            uint32_t gy = (uint32_t)((points.y[i] - minY) * sy);
+            codes[i] = spreadBits16(gx) | (spreadBits16(gy) << 1);
+        }
+    }
+    return sortByCode(codes);
+}
+
+// 按 Morton 码重排后的查询坐标：xs/ys(/zs) 连续存放，order[k] 为第 k 个点在原数组中的下标。
+// 批量查询按此顺序顺序读取坐标，结果再按 order 写回原始位置。
+struct MortonBatch {
+    std::vector<uint32_t> order;
+    std::vector<double> xs, ys, zs;
+
+    explicit MortonBatch(const PointArray& points)
+        : order(mortonOrder(points)), xs(order.size()), ys(order.size()) {
+        for (size_t k = 0; k < order.size(); ++k) {
+            xs[k] = points.x[order[k]];
+            ys[k] = points.y[order[k]];
+        }
+        if (points.dims == 3) {
+            zs.resize(order.size());
+            for (size_t k = 0; k < order.size(); ++k) zs[k] = points.z[order[k]];
+        }
+    }
+
+    size_t size() const { return order.size(); }
+
+    template <int D>
+    void point(size_t k, double* q) const {
+        q[0] = xs[k];
+        q[1] = ys[k];
+        if constexpr (D == 3) q[2] = zs[k];
+    }
+};
+
+// 软件预取（只读、保留在各级缓存），不支持的编译器上为空操作
+inline void prefetchRead(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p, 0, 3);
+#elif defined(_MSC_VER)
+    _mm_prefetch((const char*)p, _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
+// 只读内存映射一个文件，析构时解除映射。
+// sequential 为 true 时按顺序扫描提示内核预读（CSV），否则提示整体预取（索引文件随机访问）
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename, bool sequential = true) {
+#ifdef _WIN32
+        (void)sequential;
+        file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(file, &sz) || sz.QuadPart == 0) return;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL) return;
+        data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (data != nullptr) size = (size_t)sz.QuadPart;
+#else
+        fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) return;
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) return;
+        madvise(p, (size_t)st.st_size, sequential ? MADV_SEQUENTIAL : MADV_WILLNEED);
+        data = static_cast<const char*>(p);
+        size = (size_t)st.st_size;
+#endif
+        ok = true;
+    }
+    ~MappedFile() {
+#ifdef _WIN32
+        if (data != nullptr) UnmapViewOfFile(data);
+        if (mapping != NULL) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data != nullptr) munmap(const_cast<char*>(data), size);
+        if (fd >= 0) close(fd);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 文件能打开即为 true（空文件 data 为 nullptr、size 为 0）
+    bool isOpen() const { return ok; }
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool ok = false;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+};
+
+// 返回 [p, end) 中下一行的起点
+inline const char* nextLine(const char* p, const char* end) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return nl == nullptr ? end : nl + 1;
+}
+
+// 判断以 p 开头的一行是否为空行（兼容 \r\n 换行）
+inline bool isBlankLine(const char* p, const char* end) {
+    return p == end || *p == '\n' || *p == '\r';
+}
+
+// 由表头判断维数：第 4 列名为 z 时为 3D（id,x,y,z[,nucleus_id]），否则为 2D
+inline int headerDimensions(const char* p, const char* end) {
+    const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (lineEnd == nullptr) lineEnd = end;
+    for (int col = 0; col < 3; ++col) {
+        p = static_cast<const char*>(std::memchr(p, ',', lineEnd - p));
+        if (p == nullptr) return 2;
+        ++p;
+    }
+    const char* q = p;
+    while (q < lineEnd && *q != ',' && *q != '\r') ++q;
+    return (q - p == 1 && *p == 'z') ? 3 : 2;
+}
+
+// 读取 CSV 表头判断维数，文件无法打开时按 2D 处理
+inline int csvDimensions(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    std::string header;
+    std::getline(in, header);
+    return headerDimensions(header.data(), header.data() + header.size());
+}
+
+// 命令行入口用：由 spots 文件（以及给出时的 nuclei 文件）判断维数，两者不一致时报错并返回 0
+inline int inputDimensions(const std::string& nucleiFile, const std::string& spotsFile) {
+    int dims = csvDimensions(spotsFile);
+    if (!nucleiFile.empty() && csvDimensions(nucleiFile) != dims) {
+        std::cerr << "Error: " << nucleiFile << " and " << spotsFile
+                  << " must both be 2D (id,x,y) or both 3D (id,x,y,z)" << std::endl;
+        return 0;
+    }
+    return dims;
+}
+
+// 解析一行 id,x,y[,z][,nucleus_id] 写入 out 的第 row 行，格式错误返回 false
+template <int D>
+inline bool parsePointLine(const char* p, const char* end, bool isSpot,
+                           PointArray& out, size_t row) {
+    auto r = std::from_chars(p, end, out.id[row]);
+    if (r.ec != std::errc() || r.ptr == end || *r.ptr != ',') return false;
+    r = std::from_chars(r.ptr + 1, end, out.x[row]);
+    if (r.ec != std::errc() || r.ptr == end || *r.ptr != ',') return false;
+    r = std::from_chars(r.ptr + 1, end, out.y[row]);
+    if (r.ec != std::errc()) return false;
+    if constexpr (D == 3) {
+        if (r.ptr == end || *r.ptr != ',') return false;
+        r = std::from_chars(r.ptr + 1, end, out.z[row]);
+        if (r.ec != std::errc()) return false;
+    }
+    if (isSpot) {
+        if (r.ptr == end || *r.ptr != ',') return false;
+        r = std::from_chars(r.ptr + 1, end, out.nucleus_id[row]);
+        if (r.ec != std::errc()) return false;
+    } else {
+        out.nucleus_id[row] = -1;
+    }
+    return true;
 }
 
-// 从CSV文件读取点数据
-inline std::vector<Point> readPointsFromCSV(const std::string& filename, bool isSpot = false) {
-    std::vector<Point> points;
-    std::ifstream file(filename);
-    std::string line;
-    
+// 从CSV文件读取点数据，直接得到按列存放的数组。
+// 文件整体内存映射后按行边界切成若干段，第一遍各线程统计本段行数，
+// 前缀和得到每段的写入位置，第二遍各线程用 from_chars 并行解析。
+// 格式错误的行不占行号，只计入警告；各段解析完后把有效行依次前移、压实。
+inline PointArray readPointArrayCSV(const std::string& filename, bool isSpot = false) {
+    PointArray points;
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return points;
+    }
     // 跳过表头
-    std::getline(file, line);
-    
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string token;
-        std::vector<std::string> tokens;
-        
-        while (std::getline(ss, token, ',')) {
-            tokens.push_back(token);
+    const char* body = nextLine(file.begin(), file.end());
+    const char* end = file.end();
+    points.dims = headerDimensions(file.begin(), body);
+
+    // 按字节均分，再把每段起点推到下一行开头
+    size_t numChunks = std::max<size_t>(1, std::min<size_t>(numWorkerThreads() * 4,
+                                                            (end - body) / (1 << 20) + 1));
+    std::vector<const char*> bounds(numChunks + 1);
+    bounds[0] = body;
+    bounds[numChunks] = end;
+    for (size_t c = 1; c < numChunks; ++c) {
+        const char* p = body + (end - body) * c / numChunks;
+        bounds[c] = std::max(bounds[c - 1], p == body ? body : nextLine(p - 1, end));
+    }
+
+    std::vector<size_t> rows(numChunks + 1, 0);
+    parallelFor(numChunks, 1, [&](size_t c, size_t) {
+        size_t n = 0;
+        for (const char* p = bounds[c]; p < bounds[c + 1]; p = nextLine(p, end)) {
+            if (!isBlankLine(p, end)) ++n;
+        }
+        rows[c + 1] = n;
+    });
+    for (size_t c = 0; c < numChunks; ++c) rows[c + 1] += rows[c];
+
+    points.resize(rows[numChunks]);
+
+    // kept[c]：第 c 段中解析成功的行数，写在 [rows[c], rows[c] + kept[c])
+    std::vector<size_t> kept(numChunks, 0);
+    parallelFor(numChunks, 1, [&](size_t c, size_t) {
+        size_t row = rows[c];
+        for (const char* p = bounds[c]; p < bounds[c + 1]; p = nextLine(p, end)) {
+            if (isBlankLine(p, end)) continue;
+            bool ok = points.dims == 3 ? parsePointLine<3>(p, end, isSpot, points, row)
+                                       : parsePointLine<2>(p, end, isSpot, points, row);
+            if (ok) ++row;
         }
-        
-        int id = std::stoi(tokens[0]);
-        double x = std::stod(tokens[1]);
-        double y = std::stod(tokens[2]);
-        int nucleus_id = isSpot ? std::stoi(tokens[3]) : -1;
-        
-        points.emplace_back(id, x, y, nucleus_id);
-    }
-    
+        kept[c] = row - rows[c];
+    });
+    size_t total = 0;
+    for (size_t c = 0; c < numChunks; ++c) {
+        for (size_t i = 0; i < kept[c]; ++i) points.moveRow(rows[c] + i, total + i);
+        total += kept[c];
+    }
+    size_t badLines = rows[numChunks] - total;
+    points.resize(total);
+    if (badLines > 0) {
+        std::cerr << "Warning: " << badLines << " malformed lines in " << filename << std::endl;
+    }
     return points;
 }
 
+// 按表头中的列名读取一列浮点数，列不存在或文件无法打开时返回空数组
+inline std::vector<double> readDoubleColumnCSV(const std::string& filename, const std::string& column) {
+    std::vector<double> values;
+    MappedFile file(filename);
+    if (!file.isOpen()) return values;
+    const char* end = file.end();
+    const char* body = nextLine(file.begin(), end);
+
+    // 在表头中定位列
+    int col = -1, k = 0;
+    const char* p = file.begin();
+    while (p < body) {
+        const char* q = p;
+        while (q < body && *q != ',' && *q != '\n' && *q != '\r') ++q;
+        if (std::string(p, q) == column) col = k;
+        ++k;
+        p = q + 1;
+        if (q < body && *q != ',') break;
+    }
+    if (col < 0) return values;
+
+    for (const char* line = body; line < end; line = nextLine(line, end)) {
+        if (isBlankLine(line, end)) continue;
+        const char* f = line;
+        for (int c = 0; c < col && f < end; ++c) {
+            while (f < end && *f != ',' && *f != '\n') ++f;
+            if (f < end && *f == ',') ++f;
+        }
+        double v = 0.0;
+        std::from_chars(f, end, v);
+        values.push_back(v);
+    }
+    return values;
+}
+
 // 将匹配结果写入文件
 inline void writeResults(const std::string& filename, 
                         const std::vector<std::pair<int, int>>& matches) {
@@ -64,4 +474,195 @@ inline void writeResults(const std::string& filename,
     }
 }
 
+// 顺序读取 spots CSV，每次最多解析 maxRows 行；内存占用只与块大小有关，与文件大小无关
+class CSVChunkReader {
+public:
+    CSVChunkReader(const std::string& filename, bool isSpot)
+        : file(std::fopen(filename.c_str(), "rb")), isSpot(isSpot), buffer(READ_BLOCK) {
+        if (file == nullptr) {
+            std::cerr << "Error: Cannot open file " << filename << std::endl;
+            return;
+        }
+        // 读取表头，确定维数
+        const char* line;
+        const char* lineEnd;
+        if (nextRawLine(line, lineEnd)) dims = headerDimensions(line, lineEnd);
+    }
+    ~CSVChunkReader() {
+        if (file != nullptr) std::fclose(file);
+    }
+    CSVChunkReader(const CSVChunkReader&) = delete;
+    CSVChunkReader& operator=(const CSVChunkReader&) = delete;
+
+    // 读取下一块到 out，返回读到的有效行数，0 表示文件结束；格式错误的行跳过并计数
+    size_t next(PointArray& out, size_t maxRows) {
+        out.dims = dims;
+        out.resize(maxRows);
+        size_t rows = 0;
+        const char* line;
+        const char* lineEnd;
+        while (rows < maxRows && nextRawLine(line, lineEnd)) {
+            if (isBlankLine(line, lineEnd)) continue;
+            bool ok = dims == 3 ? parsePointLine<3>(line, lineEnd, isSpot, out, rows)
+                                : parsePointLine<2>(line, lineEnd, isSpot, out, rows);
+            if (ok) {
+                ++rows;
+            } else {
+                badLines++;
+            }
+        }
+        out.resize(rows);
+        return rows;
+    }
+
+    size_t malformedLines() const { return badLines; }
+
+private:
+    static const size_t READ_BLOCK = 4 << 20;
+    std::FILE* file;
+    bool isSpot;
+    int dims = 2;
+    std::vector<char> buffer;
+    size_t pos = 0, filled = 0;
+    bool eof = false;
+    size_t badLines = 0;
+
+    // 取出下一行 [line, lineEnd)（不含换行符），缓冲区不足时补读
+    bool nextRawLine(const char*& line, const char*& lineEnd) {
+        if (file == nullptr) return false;
+        while (true) {
+            const char* begin = buffer.data() + pos;
+            const char* end = buffer.data() + filled;
+            const char* nl = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+            if (nl != nullptr) {
+                line = begin;
+                lineEnd = nl;
+                pos = nl + 1 - buffer.data();
+                return true;
+            }
+            if (eof) {
+                if (begin == end) return false;
+                line = begin;
+                lineEnd = end;
+                pos = filled;
+                return true;
+            }
+            // 把未处理的残行移到缓冲区开头，行过长时扩容
+            size_t rest = filled - pos;
+            std::memmove(buffer.data(), buffer.data() + pos, rest);
+            pos = 0;
+            filled = rest;
+            if (filled == buffer.size()) buffer.resize(buffer.size() * 2);
+            size_t got = std::fread(buffer.data() + filled, 1, buffer.size() - filled, file);
+            filled += got;
+            if (got == 0) eof = true;
+        }
+    }
+};
+
+// 容量受限的阻塞队列，用于流水线各阶段之间传递数据块；close() 后 pop 取完剩余元素即返回 false
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&] { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&] { return !items.empty() || closed; });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    std::deque<T> items;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+};
+
+// 流式匹配中在各阶段间传递的一块 spots 及其匹配结果
+struct SpotChunk {
+    PointArray spots;
+    std::vector<int> nucleus;
+};
+
+// 默认每块 spots 行数
+const size_t STREAM_CHUNK_ROWS = 1 << 20;
+
+// 流式匹配：读取、匹配、写出三个阶段组成流水线并行执行。
+// 读线程按块解析 spots，主线程调用 matchChunk(spots) 得到每个 spot 的 nucleus id（可在内部多线程），
+// 写线程把结果追加到输出文件。队列容量为 2，同时在内存中的块数有上限，峰值内存与 spots 总数无关。
+// 返回处理的 spot 总数。
+template <typename MatchFn>
+inline size_t streamMatch(const std::string& spotsFile, const std::string& outputFile,
+                          size_t chunkRows, MatchFn matchChunk) {
+    BoundedQueue<SpotChunk> toMatch(2), toWrite(2);
+    CSVChunkReader reader(spotsFile, true);
+
+    std::thread readThread([&] {
+        while (true) {
+            SpotChunk chunk;
+            if (reader.next(chunk.spots, chunkRows) == 0) break;
+            toMatch.push(std::move(chunk));
+        }
+        toMatch.close();
+    });
+
+    std::thread writeThread([&] {
+        std::FILE* out = std::fopen(outputFile.c_str(), "wb");
+        if (out == nullptr) {
+            std::cerr << "Error: Cannot create output file " << outputFile << std::endl;
+        } else {
+            std::fputs("spot_id,nucleus_id\n", out);
+        }
+        std::string text;
+        SpotChunk chunk;
+        while (toWrite.pop(chunk)) {
+            if (out == nullptr) continue;
+            text.clear();
+            char num[16];
+            for (size_t i = 0; i < chunk.spots.size(); ++i) {
+                text.append(num, std::to_chars(num, num + sizeof(num), chunk.spots.id[i]).ptr);
+                text.push_back(',');
+                text.append(num, std::to_chars(num, num + sizeof(num), chunk.nucleus[i]).ptr);
+                text.push_back('\n');
+            }
+            std::fwrite(text.data(), 1, text.size(), out);
+        }
+        if (out != nullptr) std::fclose(out);
+    });
+
+    size_t total = 0;
+    SpotChunk chunk;
+    while (toMatch.pop(chunk)) {
+        chunk.nucleus = matchChunk(chunk.spots);
+        total += chunk.spots.size();
+        toWrite.push(std::move(chunk));
+    }
+    toWrite.close();
+    readThread.join();
+    writeThread.join();
+    if (reader.malformedLines() > 0) {
+        std::cerr << "Warning: " << reader.malformedLines() << " malformed lines in " << spotsFile << std::endl;
+    }
+    return total;
+}
+
 #endif // UTILS_H
\ No newline at end of file
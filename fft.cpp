@@ -3,81 +3,966 @@
 #include <complex>
 #include <cmath>
 #include <algorithm>
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <deque>
 using namespace std;
 
 using cd = complex<double>;
 const double PI = acos(-1.0);
 
-// 递归实现 
-void fft(vector<cd> & a, bool invert) {
-	int n = a.size();
-	if (n == 1) return;
+// 单位根表：roots[len + j] = e^{i·π·j/len}（len 为 2 的幂，0 <= j < len），
+// 即长度为 2·len 的蝶形层所需的全部旋转因子。每一项都直接由 cos/sin 求得，
+// 不再用 w = w * wn 累乘，误差不随长度累积；表只增不减，各次调用共用。
+vector<cd> roots{cd(0, 0), cd(1, 0)};
+
+// 位逆序置换表，revTables[k] 对应长度 2^k，按需生成后缓存
+vector<vector<int>> revTables;
+
+void prepareRoots(int n) {
+	int have = roots.size();
+	if (have >= n) return;
+	roots.resize(n);
+	for (int len = have; len < n; len *= 2) {
+		for (int j = 0; j < len; ++j) {
+			double ang = PI * j / len;
+			roots[len + j] = cd(cos(ang), sin(ang));
+		}
+	}
+}
+
+const vector<int> & bitReverse(int n) {
+	int logn = 0;
+	while ((1 << logn) < n) {
+		logn++;
+	}
+	if ((int)revTables.size() <= logn) {
+		revTables.resize(logn + 1);
+	}
+	vector<int> & rev = revTables[logn];
+	if (rev.empty()) {
+		rev.resize(n);
+		rev[0] = 0;
+		for (int i = 1; i < n; ++i) {
+			rev[i] = (rev[i >> 1] >> 1) | ((i & 1) << (logn - 1));
+		}
+	}
+	return rev;
+}
+
+// 复数乘法，按定义展开，省去 std::complex 对 inf/NaN 的特殊处理
+inline cd mul(const cd & x, const cd & y) {
+	return cd(x.real() * y.real() - x.imag() * y.imag(),
+	          x.real() * y.imag() + x.imag() * y.real());
+}
+
+// 自底向上逐层蝶形，标量版本
+void fftStagesScalar(cd * a, int n) {
+	for (int len = 1; len < n; len *= 2) {
+		for (int i = 0; i < n; i += 2 * len) {
+			for (int j = 0; j < len; ++j) {
+				cd u = a[i + j];
+				cd v = mul(a[i + j + len], roots[len + j]);
+				a[i + j] = u + v;
+				a[i + j + len] = u - v;
+			}
+		}
+	}
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FFT_HAS_AVX2_KERNEL 1
+
+// 一个 __m256d 装两个相邻的复数 (re, im, re, im)，与单位根逐对相乘：
+// 实部 xr·wr - xi·wi、虚部 xi·wr + xr·wi 由一条 fmaddsub 完成
+__attribute__((target("avx2,fma")))
+inline __m256d mulAvx2(__m256d x, __m256d w) {
+	__m256d wr = _mm256_movedup_pd(w);
+	__m256d wi = _mm256_permute_pd(w, 0xF);
+	__m256d xs = _mm256_permute_pd(x, 0x5);
+	return _mm256_fmaddsub_pd(x, wr, _mm256_mul_pd(xs, wi));
+}
+
+// AVX2 版本：每条指令处理两对蝶形。len = 1 的一层单位根恒为 1，单独做加减；
+// 之后每次把 len、2·len 两层合成一趟 radix-4（4 个点读入寄存器、做完两层再写回），
+// 对数组的遍历次数减半，运算与两趟 radix-2 完全相同。层数为奇数时最后补一趟 radix-2。
+__attribute__((target("avx2,fma")))
+void fftStagesAvx2(cd * a, int n) {
+	for (int i = 0; i < n; i += 2) {
+		cd u = a[i], v = a[i + 1];
+		a[i] = u + v;
+		a[i + 1] = u - v;
+	}
+	
+	double * d = reinterpret_cast<double *>(a);
+	const double * w = reinterpret_cast<const double *>(roots.data());
+	int len = 2;
+	for (; 4 * len <= n; len *= 4) {
+		for (int i = 0; i < n; i += 4 * len) {
+			double * x0 = d + 2 * i;
+			double * x1 = x0 + 2 * len;
+			double * x2 = x1 + 2 * len;
+			double * x3 = x2 + 2 * len;
+			for (int j = 0; j < 2 * len; j += 4) {
+				__m256d w1 = _mm256_loadu_pd(w + 2 * len + j);
+				__m256d w2 = _mm256_loadu_pd(w + 4 * len + j);
+				__m256d w3 = _mm256_loadu_pd(w + 6 * len + j);
+				__m256d a0 = _mm256_loadu_pd(x0 + j);
+				__m256d a1 = mulAvx2(_mm256_loadu_pd(x1 + j), w1);
+				__m256d a2 = _mm256_loadu_pd(x2 + j);
+				__m256d a3 = mulAvx2(_mm256_loadu_pd(x3 + j), w1);
+				__m256d b0 = _mm256_add_pd(a0, a1), b1 = _mm256_sub_pd(a0, a1);
+				__m256d b2 = mulAvx2(_mm256_add_pd(a2, a3), w2);
+				__m256d b3 = mulAvx2(_mm256_sub_pd(a2, a3), w3);
+				_mm256_storeu_pd(x0 + j, _mm256_add_pd(b0, b2));
+				_mm256_storeu_pd(x2 + j, _mm256_sub_pd(b0, b2));
+				_mm256_storeu_pd(x1 + j, _mm256_add_pd(b1, b3));
+				_mm256_storeu_pd(x3 + j, _mm256_sub_pd(b1, b3));
+			}
+		}
+	}
+	if (len < n) {
+		for (int i = 0; i < n; i += 2 * len) {
+			double * x = d + 2 * i;
+			double * y = x + 2 * len;
+			for (int j = 0; j < 2 * len; j += 4) {
+				__m256d u = _mm256_loadu_pd(x + j);
+				__m256d v = mulAvx2(_mm256_loadu_pd(y + j), _mm256_loadu_pd(w + 2 * len + j));
+				_mm256_storeu_pd(x + j, _mm256_add_pd(u, v));
+				_mm256_storeu_pd(y + j, _mm256_sub_pd(u, v));
+			}
+		}
+	}
+}
+
+__attribute__((target("avx2,fma")))
+void fftStageRangeAvx2(cd * a, int len, int tlo, int thi) {
+	double * d = reinterpret_cast<double *>(a);
+	const double * w = reinterpret_cast<const double *>(roots.data() + len);
+	int lg = __builtin_ctz(len);
+	for (int t = tlo; t < thi;) {
+		int j0 = t & (len - 1), jend = min(len, j0 + (thi - t));
+		double * x = d + ((size_t)(t >> lg) << (lg + 2));
+		double * y = x + 2 * len;
+		for (int j = 2 * j0; j < 2 * jend; j += 4) {
+			__m256d u = _mm256_loadu_pd(x + j);
+			__m256d v = mulAvx2(_mm256_loadu_pd(y + j), _mm256_loadu_pd(w + j));
+			_mm256_storeu_pd(x + j, _mm256_add_pd(u, v));
+			_mm256_storeu_pd(y + j, _mm256_sub_pd(u, v));
+		}
+		t += jend - j0;
+	}
+}
+#endif
+
+// 第 len 层中编号在 [tlo, thi) 内的蝶形，编号 t 对应第 t / len 组的第 t % len 对。
+// 多线程时把一层切给多个线程用；运算与整段版本逐个相同（AVX2 版本要求 len >= 2、tlo 和 thi 为偶数）
+void fftStageRangeScalar(cd * a, int len, int tlo, int thi) {
+	int lg = __builtin_ctz(len);
+	for (int t = tlo; t < thi;) {
+		int j0 = t & (len - 1), jend = min(len, j0 + (thi - t));
+		cd * x = a + ((size_t)(t >> lg) << (lg + 1));
+		cd * y = x + len;
+		for (int j = j0; j < jend; ++j) {
+			cd u = x[j];
+			cd v = mul(y[j], roots[len + j]);
+			x[j] = u + v;
+			y[j] = u - v;
+		}
+		t += jend - j0;
+	}
+}
+
+// 运行时按 CPU 选择蝶形实现，只判断一次（在全局初始化阶段调用，须先 __builtin_cpu_init）
+void (*chooseFftStages())(cd *, int) {
+#ifdef FFT_HAS_AVX2_KERNEL
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		return fftStagesAvx2;
+	}
+#endif
+	return fftStagesScalar;
+}
+void (*const fftStages)(cd *, int) = chooseFftStages();
+
+void (*chooseFftStageRange())(cd *, int, int, int) {
+#ifdef FFT_HAS_AVX2_KERNEL
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		return fftStageRangeAvx2;
+	}
+#endif
+	return fftStageRangeScalar;
+}
+void (*const fftStageRange)(cd *, int, int, int) = chooseFftStageRange();
+
+// 固定大小的线程池，各处的 parallelFor 都交给它执行，线程只创建一次。
+// main 按 --threads 设置线程数（默认为 hardware_concurrency），未设置时全部在调用线程中执行。
+class ThreadPool {
+public:
+	~ThreadPool() {
+		stop();
+	}
 	
-	vector<cd> a0(n / 2), a1(n / 2);
-	for (int i = 0; i < n / 2; ++i) {
-		a0[i] = a[2 * i];
-		a1[i] = a[2 * i + 1];
+	// 线程总数，含调用线程；1 表示单线程
+	int size() const {
+		return (int)workers.size() + 1;
 	}
 	
-	fft(a0, invert);
-	fft(a1, invert);
+	void resize(int threads) {
+		stop();
+		stopping = false;
+		for (int k = 1; k < threads; ++k) {
+			workers.emplace_back([this] { workerLoop(); });
+		}
+	}
 	
-	double sign;
-	if (invert) {
-		sign = -1.0;
-	} else {
-		sign = 1.0;
+	// 把 [0, count) 切成若干段，由调用线程和池中线程按原子计数领取，执行 f(begin, end)，全部完成后返回。
+	// 调用线程自己也领取，即使池中线程都在忙（例如段内再次调用 parallelFor）也能独自做完，不会死锁
+	void run(int count, const function<void(int, int)> & f) {
+		int chunks = min(count, 4 * size());
+		if (chunks <= 1 || workers.empty()) {
+			if (count > 0) {
+				f(0, count);
+			}
+			return;
+		}
+		auto job = make_shared<Job>();
+		job->f = &f;
+		job->count = count;
+		job->chunks = chunks;
+		{
+			lock_guard<mutex> lk(m);
+			jobs.push_back(job);
+		}
+		cv.notify_all();
+		work(*job);
+		{
+			unique_lock<mutex> lk(job->m);
+			job->cv.wait(lk, [&] { return job->done == job->chunks; });
+		}
+		lock_guard<mutex> lk(m);
+		auto it = find(jobs.begin(), jobs.end(), job);
+		if (it != jobs.end()) {
+			jobs.erase(it);
+		}
 	}
-	double ang = 2 * PI / n * sign;
-	cd w(1);
-	cd wn(cos(ang), sin(ang));
 	
-	for (int k = 0; k < n / 2; ++k) {
-		cd u = a0[k];
-		cd v = w * a1[k];
-		a[k] = u + v;
-		a[k + n / 2] = u - v;
-		if (invert) {
-			a[k] /= 2;
-			a[k + n / 2] /= 2;
+private:
+	struct Job {
+		const function<void(int, int)> * f;
+		int count, chunks;
+		atomic<int> next{0}, done{0};
+		mutex m;
+		condition_variable cv;
+	};
+	
+	vector<thread> workers;
+	deque<shared_ptr<Job>> jobs;
+	mutex m;
+	condition_variable cv;
+	bool stopping = false;
+	
+	// 领取并执行 job 中尚未开始的段，最后一段完成时唤醒等待的调用线程
+	static void work(Job & job) {
+		int c;
+		while ((c = job.next++) < job.chunks) {
+			(*job.f)((long long)job.count * c / job.chunks, (long long)job.count * (c + 1) / job.chunks);
+			if (++job.done == job.chunks) {
+				lock_guard<mutex> lk(job.m);
+				job.cv.notify_all();
+			}
+		}
+	}
+	
+	void workerLoop() {
+		for (;;) {
+			shared_ptr<Job> job;
+			{
+				unique_lock<mutex> lk(m);
+				cv.wait(lk, [&] { return stopping || !jobs.empty(); });
+				if (stopping) return;
+				job = jobs.front();
+				// 各段都已被领取的任务移出队列
+				if (job->next >= job->chunks) {
+					jobs.pop_front();
+					continue;
+				}
+			}
+			work(*job);
+		}
+	}
+	
+	void stop() {
+		{
+			lock_guard<mutex> lk(m);
+			stopping = true;
+		}
+		cv.notify_all();
+		for (auto & t : workers) {
+			t.join();
+		}
+		workers.clear();
+	}
+};
+
+ThreadPool pool;
+
+template <typename F>
+void parallelFor(int count, F f) {
+	pool.run(count, f);
+}
+
+// 分块转置：src 为 rows × cols 的行主序矩阵，dst 为 cols × rows，按小块读写，各块行分给多个线程
+void transposeBlocked(const cd * src, cd * dst, int rows, int cols) {
+	const int TILE = 8;
+	parallelFor((rows + TILE - 1) / TILE, [=](int lo, int hi) {
+		for (int bi = lo * TILE; bi < min(rows, hi * TILE); bi += TILE) {
+			for (int bj = 0; bj < cols; bj += TILE) {
+				int ei = min(rows, bi + TILE), ej = min(cols, bj + TILE);
+				for (int i = bi; i < ei; ++i) {
+					for (int j = bj; j < ej; ++j) {
+						dst[(size_t)j * rows + i] = src[(size_t)i * cols + j];
+					}
+				}
+			}
+		}
+	});
+}
+
+// 长度为 len 的一段做完整的正变换：位逆序置换后逐层蝶形
+void transformRow(cd * a, int len, const vector<int> & rev) {
+	for (int i = 0; i < len; ++i) {
+		if (i < rev[i]) {
+			swap(a[i], a[rev[i]]);
 		}
-		w = w * wn;
 	}
+	fftStages(a, len);
 }
 
-vector<long long> multiply(const vector<int> & A, const vector<int> & B) {
-	int n = 1;
+// ---------- 四步法（Bailey）：n >= FOUR_STEP_MIN 时使用 ----------
+// 长度超过 L2 后，逐层蝶形每一层都要把整个数组读写一遍。四步法把数组看成 n2 行 × n1 列的矩阵
+// （x[j2·n1 + j1]，n1 = 2^{floor(log n / 2)}），记 k = k2 + n2·k1，则
+//   X[k2 + n2·k1] = Σ_{j1} ω_{n1}^{j1·k1} · ω_n^{j1·k2} · Σ_{j2} x[j2·n1 + j1] · ω_{n2}^{j2·k2}，
+// 依次为：沿列做长度 n2 的变换、乘旋转因子 ω_n^{j1·k2}、沿行做长度 n1 的变换。
+// 每次取相邻 COLS 列拷到连续缓冲区（拷入时按位逆序取行），各列在缓冲区中做完全部各层，
+// 写回时顺带乘上旋转因子；行是连续的，每行同样在缓存中做完。行距为 2 的幂，
+// 直接按列做蝶形时各行会落在同一组缓存行上互相驱逐，拷贝避免了这一点。列块和行都分给多个线程。
+// 结果 X[k2 + n2·k1] 存放在 k2·n1 + k1，即转置顺序；逆序的过程（先行、再旋转因子、再列）
+// 从转置顺序出发得到自然顺序的变换结果。卷积只做逐点运算，直接在转置顺序下进行，
+// fft() 需要自然顺序时再补一次分块转置。
+const int FOUR_STEP_MIN = 1 << 20;
+const int COLS = 8;
+
+void splitSize(int n, int & n1, int & n2) {
+	int logn = __builtin_ctz(n);
+	n1 = 1 << (logn / 2);
+	n2 = n / n1;
+}
+
+// 旋转因子矩阵：tw[r·n1 + c] = ω_n^{r·c}，与数据同样布局，列块处理时按同样的位置顺序读取。
+// 每一项都由 (r·c) mod n 直接求 cos/sin，只有一次舍入：若用两张短表相乘（ω_n^m = high · low）
+// 会多一次舍入，mod = 2^30、长 10^6 的最坏输入下足以让拆系数 FFT 的个别项舍入出错。按 log2(n) 缓存
+vector<vector<cd>> twiddleTables;
+
+const vector<cd> & twiddleMatrix(int n) {
+	int logn = __builtin_ctz(n);
+	if ((int)twiddleTables.size() <= logn) {
+		twiddleTables.resize(logn + 1);
+	}
+	vector<cd> & tw = twiddleTables[logn];
+	if (tw.empty()) {
+		int n1, n2;
+		splitSize(n, n1, n2);
+		tw.resize(n);
+		for (int r = 0; r < n2; ++r) {
+			for (int c = 0; c < n1; ++c) {
+				double ang = 2 * PI * (double)((long long)r * c % n) / n;
+				tw[(size_t)r * n1 + c] = cd(cos(ang), sin(ang));
+			}
+		}
+	}
+	return tw;
+}
+
+// 从第 col 列起的一个列块（数组 a 为 rows × stride）：twiddleFirst 为 false 时
+// 先做列变换再乘旋转因子（正向），为 true 时先乘旋转因子再做列变换（逆序过程）。
+// 元素 (r, col + c) 的旋转因子为 ω_n^{r·(col + c)}，即 tw[r·stride + col + c]
+void transformColumnBlock(cd * a, int col, int rows, int stride, const vector<int> & rev,
+                          const cd * tw, bool twiddleFirst) {
+	static thread_local vector<cd> block;
+	block.resize((size_t)rows * COLS);
+	cd * b = block.data();
+	for (int r = 0; r < rows; ++r) {
+		const cd * x = a + (size_t)rev[r] * stride + col;
+		for (int c = 0; c < COLS; ++c) {
+			b[(size_t)c * rows + r] = twiddleFirst ? mul(x[c], tw[(size_t)rev[r] * stride + col + c]) : x[c];
+		}
+	}
+	for (int c = 0; c < COLS; ++c) {
+		fftStages(b + (size_t)c * rows, rows);
+	}
+	for (int r = 0; r < rows; ++r) {
+		cd * x = a + (size_t)r * stride + col;
+		for (int c = 0; c < COLS; ++c) {
+			const cd & y = b[(size_t)c * rows + r];
+			x[c] = twiddleFirst ? y : mul(y, tw[(size_t)r * stride + col + c]);
+		}
+	}
+}
+
+// 四步法变换。forward 为 true 时输入自然顺序、输出转置顺序；为 false 时输入转置顺序、输出自然顺序
+void fourStep(cd * f, int n, bool forward) {
+	int n1, n2;
+	splitSize(n, n1, n2);
+	const vector<int> & rev1 = bitReverse(n1);
+	const vector<int> & rev2 = bitReverse(n2);
+	const cd * tw = twiddleMatrix(n).data();
 	
-	while (n < (int)A.size() + (int)B.size()) {
+	auto columns = [=, &rev2](int lo, int hi) {
+		for (int blk = lo; blk < hi; ++blk) {
+			transformColumnBlock(f, blk * COLS, n2, n1, rev2, tw, !forward);
+		}
+	};
+	auto rows = [=, &rev1](int lo, int hi) {
+		for (int r = lo; r < hi; ++r) {
+			transformRow(f + (size_t)r * n1, n1, rev1);
+		}
+	};
+	if (forward) {
+		parallelFor(n1 / COLS, columns);
+		parallelFor(n2, rows);
+	} else {
+		parallelFor(n2, rows);
+		parallelFor(n1 / COLS, columns);
+	}
+}
+
+// 不分组的整段变换（n < FOUR_STEP_MIN）。n >= PARALLEL_MIN 且线程池不止一个线程时：
+// 位逆序按下标分段并行（每对交换只由较小下标所在的段执行）；前 log(n / segs) 层只在
+// 长为 n / segs 的段内进行，各段交给不同线程；之后的每一层把 n/2 个蝶形按编号等分。
+// 每个蝶形的运算与单线程时完全相同（AVX2 的 radix-4 一趟与两趟 radix-2 也相同），结果逐位一致。
+const int PARALLEL_MIN = 1 << 16;
+
+void transformWhole(cd * a, int n) {
+	const vector<int> & rev = bitReverse(n);
+	int threads = pool.size();
+	if (threads <= 1 || n < PARALLEL_MIN) {
+		transformRow(a, n, rev);
+		return;
+	}
+	parallelFor(n, [=, &rev](int lo, int hi) {
+		for (int i = lo; i < hi; ++i) {
+			if (i < rev[i]) {
+				swap(a[i], a[rev[i]]);
+			}
+		}
+	});
+	int segs = 1;
+	while (segs < threads && segs < n / 16) {
+		segs *= 2;
+	}
+	int seg = n / segs, part = n / 2 / segs;
+	parallelFor(segs, [=](int lo, int hi) {
+		for (int k = lo; k < hi; ++k) {
+			fftStages(a + (size_t)k * seg, seg);
+		}
+	});
+	for (int len = seg; len < n; len *= 2) {
+		parallelFor(segs, [=](int lo, int hi) {
+			fftStageRange(a, len, lo * part, hi * part);
+		});
+	}
+}
+
+// ---------- 混合基：长度 n = 3·m（m 为 2 的幂） ----------
+// 所需长度刚超过 2 的幂时，取 2 的幂几乎要把长度翻倍，改用 3·2^k 可省下约四分之一。
+// 按频率分解：记 x_r[i] = x[i + r·m]，则
+//   X[3k + t] = Σ_i ω_m^{i·k} · ω_n^{i·t} · Σ_r ω_3^{r·t} · x_r[i]，t = 0, 1, 2，
+// 即先对连续的三段逐点做一层 radix-3 并乘旋转因子 ω_n^{i·t}（原地写回第 t 段），
+// 再对三段各做长度 m 的 fftUnordered。第 t 段位置 p 存放频率 3·k(p) + t，k(p) 为子变换中位置 p 的频率。
+// 逆变换按相反的顺序：三段各做逆变换，再做 radix-3 的逆。
+
+// radix-3 一层的旋转因子：w1[i] = ω_n^i，w2[i] = ω_n^{2i}（0 <= i < m）。按 log2(m) 缓存
+struct Radix3Table {
+	vector<cd> w1, w2;
+};
+vector<Radix3Table> radix3Tables;
+
+const Radix3Table & radix3Table(int m) {
+	int logm = __builtin_ctz(m);
+	if ((int)radix3Tables.size() <= logm) {
+		radix3Tables.resize(logm + 1);
+	}
+	Radix3Table & t = radix3Tables[logm];
+	if (t.w1.empty()) {
+		t.w1.resize(m);
+		t.w2.resize(m);
+		for (int i = 0; i < m; ++i) {
+			double ang = 2 * PI * i / (3.0 * m);
+			t.w1[i] = cd(cos(ang), sin(ang));
+			t.w2[i] = cd(cos(2 * ang), sin(2 * ang));
+		}
+	}
+	return t;
+}
+
+// 生成长度 n 的变换需要的全部缓存表。表生成后只读，多线程同时变换前先在当前线程调用一次
+void prepareTransform(int n) {
+	if (n & (n - 1)) {
+		prepareTransform(n / 3);
+		radix3Table(n / 3);
+		return;
+	}
+	if (n < FOUR_STEP_MIN) {
+		prepareRoots(n);
+		bitReverse(n);
+		return;
+	}
+	int n1, n2;
+	splitSize(n, n1, n2);
+	prepareRoots(max(n1, n2));
+	bitReverse(n1);
+	bitReverse(n2);
+	twiddleMatrix(n);
+}
+
+// 卷积长度至少为 len 时使用的变换长度：2^k 与 3·2^k 中不小于 len 的最小者
+int transformSize(int len) {
+	int n = 1, n3 = 3;
+	while (n < len) {
 		n = n * 2;
 	}
+	while (n3 < len) {
+		n3 = n3 * 2;
+	}
+	return min(n, n3);
+}
+
+void fftUnordered(cd * a, int n, bool invert);
+
+// 长度 3·m 的变换，见上。三段的子变换互相独立，交给线程池同时进行
+void fftRadix3(cd * a, int n, bool invert) {
+	int m = n / 3;
+	const Radix3Table & tw = radix3Table(m);
+	const cd * w1 = tw.w1.data();
+	const cd * w2 = tw.w2.data();
+	// ω_3 = -1/2 + i·√3/2，ω_3^2 = -1/2 - i·√3/2
+	const double h = sqrt(3.0) / 2;
+	auto subTransforms = [=](int lo, int hi) {
+		for (int t = lo; t < hi; ++t) {
+			fftUnordered(a + (size_t)t * m, m, invert);
+		}
+	};
+	
+	if (!invert) {
+		parallelFor(m, [=](int lo, int hi) {
+			for (int i = lo; i < hi; ++i) {
+				cd x0 = a[i], x1 = a[m + i], x2 = a[2 * m + i];
+				cd s = x1 + x2, d = x1 - x2;
+				cd base = x0 - 0.5 * s, rot(-h * d.imag(), h * d.real());
+				a[i] = x0 + s;
+				a[m + i] = mul(base + rot, w1[i]);
+				a[2 * m + i] = mul(base - rot, w2[i]);
+			}
+		});
+		parallelFor(3, subTransforms);
+	} else {
+		parallelFor(3, subTransforms);
+		const double third = 1.0 / 3;
+		parallelFor(m, [=](int lo, int hi) {
+			for (int i = lo; i < hi; ++i) {
+				cd v0 = a[i], v1 = mul(a[m + i], conj(w1[i])), v2 = mul(a[2 * m + i], conj(w2[i]));
+				cd s = v1 + v2, d = v1 - v2;
+				cd base = v0 - 0.5 * s, rot(-h * d.imag(), h * d.real());
+				a[i] = (v0 + s) * third;
+				a[m + i] = (base - rot) * third;
+				a[2 * m + i] = (base + rot) * third;
+			}
+		});
+	}
+}
+
+// 只用于逐点运算的变换，n 为 2^k 或 3·2^k：长度达到 FOUR_STEP_MIN 时正变换的结果为转置顺序，
+// 长度为 3·2^k 时为上述混合基的顺序（见 conjugatePairs），逆变换也从同样的顺序出发，
+// 省去转置；更短的 2 的幂与 fft() 相同。
+// 逆变换利用 IDFT(a)[k] = DFT(a)[(n - k) mod n] / n，与正变换共用同一张单位根表。
+void fftUnordered(cd * a, int n, bool invert) {
+	if (n == 1) return;
+	
+	prepareTransform(n);
+	if (n & (n - 1)) {
+		fftRadix3(a, n, invert);
+		return;
+	}
+	if (n >= FOUR_STEP_MIN) {
+		fourStep(a, n, !invert);
+	} else {
+		transformWhole(a, n);
+	}
+	
+	if (invert) {
+		reverse(a + 1, a + n);
+		for (int i = 0; i < n; ++i) {
+			a[i] /= n;
+		}
+	}
+}
+
+void fftUnordered(vector<cd> & a, bool invert) {
+	fftUnordered(a.data(), a.size(), invert);
+}
+
+// 迭代、原地实现：先做位逆序置换，再自底向上逐层蝶形，不分配临时数组。
+// n 须为 2 的幂，输入输出均为自然顺序；长度达到 FOUR_STEP_MIN 时自动改用四步法，
+// 并用一次分块转置在转置顺序与自然顺序之间转换。
+void fft(vector<cd> & a, bool invert) {
+	int n = a.size();
+	if (n < FOUR_STEP_MIN) {
+		fftUnordered(a, invert);
+		return;
+	}
+	int n1, n2;
+	splitSize(n, n1, n2);
+	vector<cd> t(n);
+	if (invert) {
+		transposeBlocked(a.data(), t.data(), n1, n2);
+		a.swap(t);
+		fftUnordered(a, true);
+	} else {
+		fftUnordered(a, false);
+		transposeBlocked(a.data(), t.data(), n2, n1);
+		a.swap(t);
+	}
+}
+
+// 对 fftUnordered 正变换结果中的每一对共轭位置调用 f(i, j)：i、j 分别存放频率 k 与 (n - k) mod n，
+// 每对只调用一次（k = 0、n/2 等自共轭时 i == j）。
+// 长度较短时为自然顺序；四步法的转置顺序中 k = k2 + n2·k1 存放在 k2·n1 + k1，
+// 其共轭为 k2' = (n2 - k2) mod n2、k1' = (n1 - k1 - [k2 != 0]) mod n1，同一对所在的两行都按顺序访问。
+// 长度 3·m 时第 t 段位置 p 存放频率 3·k(p) + t：第 0 段内部按长度 m 配对；
+// 3k + 1 的共轭为 3(m - 1 - k) + 2，两种顺序下频率 m - 1 - k 都位于 m - 1 - p，第 1、2 段逐个交叉配对。
+template <typename F>
+void conjugatePairs(int n, F f) {
+	int m = n & (n - 1) ? n / 3 : n;
+	if (m != n) {
+		for (int p = 0; p < m; ++p) {
+			f(m + p, 3 * m - 1 - p);
+		}
+	}
+	if (m < FOUR_STEP_MIN) {
+		for (int i = 0; i <= m / 2; ++i) {
+			f(i, (m - i) & (m - 1));
+		}
+		return;
+	}
+	int n1, n2;
+	splitSize(m, n1, n2);
+	for (int k2 = 0; k2 <= n2 / 2; ++k2) {
+		int k2c = (n2 - k2) & (n2 - 1);
+		for (int k1 = 0; k1 < n1; ++k1) {
+			int k1c = (n1 - k1 - (k2 != 0)) & (n1 - 1);
+			if (k2c == k2 && k1c < k1) continue;
+			f(k2 * n1 + k1, k2c * n1 + k1c);
+		}
+	}
+}
+
+// 两个实序列合成一次复变换："two-for-one" 技巧。
+// 令 P = A + iB，由于 A、B 为实数，其频谱满足共轭对称，可从 P 的频谱中分离出来：
+//   FA[k] = (P[k] + conj(P[n-k])) / 2，FB[k] = (P[k] - conj(P[n-k])) / (2i)，
+// 于是 FA[k]·FB[k] = (P[k]^2 - conj(P[n-k])^2) / (4i)。
+// 只需一次正变换和一次逆变换，复数数组也只有一个。
+// 这里对 A 的前 na 项与 B 的前 nb 项做长度为 n 的循环卷积（na、nb <= n），
+// 取 [lo, hi) 各项四舍五入；超出 n 的项卷回低位
+vector<long long> cyclicProduct(const vector<int> & A, int na, const vector<int> & B, int nb, int n, int lo, int hi) {
+	vector<cd> p(n);
+	for (int i = 0; i < na; ++i) {
+		p[i].real(A[i]);
+	}
+	for (int i = 0; i < nb; ++i) {
+		p[i].imag(B[i]);
+	}
 	
-	vector<cd> fa(n), fb(n);
+	fftUnordered(p, false);
+	
+	// k 与 n-k 成对处理，原地写回；除以 4i 即乘以 -i/4
+	const cd quarterI(0, -0.25);
+	conjugatePairs(n, [&](int i, int j) {
+		cd pi = p[i], pj = p[j];
+		p[i] = mul(mul(pi, pi) - conj(mul(pj, pj)), quarterI);
+		p[j] = mul(mul(pj, pj) - conj(mul(pi, pi)), quarterI);
+	});
+	
+	fftUnordered(p, true);
+	
+	vector<long long> C(hi - lo);
+	for (int i = lo; i < hi; ++i) {
+		long long val = static_cast<long long>(round(p[i].real()));
+		C[i - lo] = val;
+	}
+	return C;
+}
+
+vector<long long> multiply(const vector<int> & A, const vector<int> & B) {
+	int len = A.size() + B.size() - 1;
+	return cyclicProduct(A, A.size(), B, B.size(), transformSize(len), 0, len);
+}
+
+// 乘积的前 k 项：两边只需前 k 项参与，变换长度按截断后的乘积长度选取
+vector<long long> multiplyTruncated(const vector<int> & A, const vector<int> & B, int k) {
+	int na = min((int)A.size(), k), nb = min((int)B.size(), k);
+	if (na == 0 || nb == 0) {
+		return vector<long long>(max(k, 0), 0);
+	}
+	int len = min(na + nb - 1, k);
+	vector<long long> C = cyclicProduct(A, na, B, nb, transformSize(na + nb - 1), 0, len);
+	C.resize(k, 0);
+	return C;
+}
+
+// 中间积：|A| >= |B| = m 时返回乘积的第 m-1 到 |A|-1 项，共 |A| - m + 1 项，
+// 即 B 反转后在 A 上滑动的各个完整窗口的相关值。乘积最高到第 |A|+m-2 项，
+// 取长度 n >= |A| 的循环卷积时超出的项卷回 [0, m-2]，不影响所需各项，变换长度约为完整乘积的一半
+vector<long long> multiplyMiddle(const vector<int> & A, const vector<int> & B) {
+	int na = A.size(), m = B.size();
+	if (m == 0 || na < m) {
+		return {};
+	}
+	return cyclicProduct(A, na, B, m, transformSize(na), m - 1, na);
+}
+
+// 拆成三段的版本，供 multiplyMod 在序列较长时使用：x = x2·2^20 + x1·2^10 + x0，各段 |xi| <= 2^9 + 1。
+// 五个和式 S_k = Σ_{i+j=k} ai*bj 的每一项不超过 3·L·2^19，比两段拆分小约三个数量级，
+// 舍入偏差在 L 达到 10^7 量级时仍远小于 0.5。
+// 用到 6 次 FFT：P = a0 + i·a1、R = a2 + i·b2、Q = b0 + i·b1 三次正变换，
+// 按共轭对称分离出各段的频谱，再对 S0 + i·S1、S2 + i·S3、S4 三次逆变换
+vector<int> multiplyModThreeWay(const vector<int> & A, const vector<int> & B, int mod) {
+	int n = transformSize(A.size() + B.size() - 1);
+	
+	const int SPLIT = 10;
+	const int MASK = (1 << SPLIT) - 1;
+	const int HALF = 1 << (SPLIT - 1);
+	// x 先取对称余数，再逐段取对称余数
+	auto split = [&](int v, int & d0, int & d1, int & d2) {
+		int x = (v % mod + mod) % mod;
+		if (x > mod / 2) {
+			x -= mod;
+		}
+		d0 = ((x + HALF) & MASK) - HALF;
+		x = (x - d0) >> SPLIT;
+		d1 = ((x + HALF) & MASK) - HALF;
+		d2 = (x - d1) >> SPLIT;
+	};
+	vector<cd> p(n), q(n), r(n);
+	int d0, d1, d2;
 	for (size_t i = 0; i < A.size(); ++i) {
-		fa[i] = cd(A[i], 0);
+		split(A[i], d0, d1, d2);
+		p[i] = cd(d0, d1);
+		r[i].real(d2);
 	}
 	for (size_t i = 0; i < B.size(); ++i) {
-		fb[i] = cd(B[i], 0);
+		split(B[i], d0, d1, d2);
+		q[i] = cd(d0, d1);
+		r[i].imag(d2);
 	}
 	
-	fft(fa, false);
-	fft(fb, false);
+	prepareTransform(n);
+	auto transformAll = [&](bool invert) {
+		parallelFor(3, [&](int lo, int hi) {
+			for (int k = lo; k < hi; ++k) {
+				fftUnordered(k == 0 ? p : k == 1 ? q : r, invert);
+			}
+		});
+	};
+	transformAll(false);
 	
-	for (int i = 0; i < n; ++i) {
-		fa[i] = fa[i] * fb[i];
+	// X = u + i·v（u、v 为实序列）时 FU[k] = (X[k] + conj(X[n-k])) / 2，FV[k] = (X[k] - conj(X[n-k])) / (2i)
+	const cd half(0.5, 0), halfI(0, -0.5), I(0, 1);
+	conjugatePairs(n, [&](int i, int j) {
+		int idx[2] = {i, j};
+		cd res[2][3];
+		for (int t = 0; t < 2; ++t) {
+			int a = idx[t], b = idx[1 - t];
+			cd a0 = mul(p[a] + conj(p[b]), half), a1 = mul(p[a] - conj(p[b]), halfI);
+			cd b0 = mul(q[a] + conj(q[b]), half), b1 = mul(q[a] - conj(q[b]), halfI);
+			cd a2 = mul(r[a] + conj(r[b]), half), b2 = mul(r[a] - conj(r[b]), halfI);
+			cd s0 = mul(a0, b0), s1 = mul(a0, b1) + mul(a1, b0);
+			cd s2 = mul(a0, b2) + mul(a1, b1) + mul(a2, b0);
+			cd s3 = mul(a1, b2) + mul(a2, b1), s4 = mul(a2, b2);
+			res[t][0] = s0 + mul(s1, I);
+			res[t][1] = s2 + mul(s3, I);
+			res[t][2] = s4;
+		}
+		for (int t = 0; t < 2; ++t) {
+			p[idx[t]] = res[t][0];
+			q[idx[t]] = res[t][1];
+			r[idx[t]] = res[t][2];
+		}
+	});
+	
+	transformAll(true);
+	
+	vector<int> C(A.size() + B.size() - 1);
+	long long w1 = (1LL << SPLIT) % mod;
+	long long w2 = (1LL << (2 * SPLIT)) % mod;
+	long long w3 = w2 * w1 % mod;
+	long long w4 = w2 * w2 % mod;
+	for (size_t i = 0; i < C.size(); ++i) {
+		long long s0 = llround(p[i].real()) % mod;
+		long long s1 = llround(p[i].imag()) % mod;
+		long long s2 = llround(q[i].real()) % mod;
+		long long s3 = llround(q[i].imag()) % mod;
+		long long s4 = llround(r[i].real()) % mod;
+		long long v = (s0 + s1 * w1 % mod + s2 * w2 % mod + s3 * w3 % mod + s4 * w4 % mod) % mod;
+		C[i] = v < 0 ? v + mod : v;
 	}
+	return C;
+}
+
+// 任意模数下的精确卷积（拆系数 FFT）。
+// 系数先对 mod 取模并平移到 (-mod/2, mod/2]，再按 15 位拆成 x = x1·2^15 + x0，
+// 两半都取对称余数，|x0|, |x1| <= 2^14。对称拆分使各子序列均值接近 0，
+// 频谱不再集中在直流分量上，舍入误差比非负拆分小一个数量级以上。
+// 四个子卷积 a0*b0、a0*b1、a1*b0、a1*b1 的每一项不超过 L·2^28（L 为较短序列的长度），
+// 再按 2^30、2^15 的权重在模意义下合并。要求 mod <= 2^30。
+// 随机系数的舍入偏差很小（两条长 10^6 的序列约 1e-3），但所有系数都取最坏拆分
+// （例如全为 2^29 - 2^14，两半均为 ±2^14）时频谱集中，偏差约与 sqrt(|A|·|B|) 成正比：
+// mod = 2^30 实测 |A| = |B| = 2^19 时为 0.25，10^6 时达到 0.5，已有个别项舍入出错。
+// 因此 |A|·|B| > TWO_WAY_MAX = 2^38 时改用拆成三段的 multiplyModThreeWay。
+// 用到 4 次 FFT：P = a0 + i·a1、Q = b0 + i·b1 各做一次正变换，
+// 按共轭对称从 P 中分离 FA0、FA1，再对 FA0·Q = FA0·FB0 + i·FA0·FB1、
+// FA1·Q = FA1·FB0 + i·FA1·FB1 各做一次逆变换，实部与虚部分别就是两个子卷积。
+const double TWO_WAY_MAX = 1LL << 38;
+
+vector<int> multiplyMod(const vector<int> & A, const vector<int> & B, int mod) {
+	if ((double)A.size() * B.size() > TWO_WAY_MAX) {
+		return multiplyModThreeWay(A, B, mod);
+	}
+	int n = transformSize(A.size() + B.size() - 1);
 	
-	fft(fa, true);
+	const int SPLIT = 15;
+	const int MASK = (1 << SPLIT) - 1;
+	const int HALF = 1 << (SPLIT - 1);
+	// x 拆成对称的两半，返回 x0 + i·x1
+	auto split = [&](int v) {
+		int x = (v % mod + mod) % mod;
+		if (x > mod / 2) {
+			x -= mod;
+		}
+		int lo = ((x + HALF) & MASK) - HALF;
+		return cd(lo, (x - lo) >> SPLIT);
+	};
+	vector<cd> p(n), q(n);
+	for (size_t i = 0; i < A.size(); ++i) {
+		p[i] = split(A[i]);
+	}
+	for (size_t i = 0; i < B.size(); ++i) {
+		q[i] = split(B[i]);
+	}
+	
+	// 两个正变换互相独立，同时进行；两个逆变换同样
+	prepareTransform(n);
+	auto transformBoth = [&](bool invert) {
+		parallelFor(2, [&](int lo, int hi) {
+			for (int k = lo; k < hi; ++k) {
+				fftUnordered(k == 0 ? p : q, invert);
+			}
+		});
+	};
+	transformBoth(false);
+	
+	// k 与 n-k 成对处理：FA0·Q 写回 p，FA1·Q 写回 q
+	const cd half(0.5, 0), halfI(0, -0.5);
+	conjugatePairs(n, [&](int i, int j) {
+		cd pi = p[i], pj = p[j], qi = q[i], qj = q[j];
+		cd a0i = mul(pi + conj(pj), half), a1i = mul(pi - conj(pj), halfI);
+		cd a0j = mul(pj + conj(pi), half), a1j = mul(pj - conj(pi), halfI);
+		p[i] = mul(a0i, qi);
+		q[i] = mul(a1i, qi);
+		p[j] = mul(a0j, qj);
+		q[j] = mul(a1j, qj);
+	});
 	
-	vector<long long> C(A.size() + B.size() - 1);
+	transformBoth(true);
+	
+	vector<int> C(A.size() + B.size() - 1);
+	long long shift15 = (1LL << SPLIT) % mod;
+	long long shift30 = (1LL << (2 * SPLIT)) % mod;
 	for (size_t i = 0; i < C.size(); ++i) {
-		long long val = static_cast<long long>(round(fa[i].real()));
-		C[i] = val;
+		long long c00 = llround(p[i].real()) % mod;
+		long long c01 = llround(p[i].imag()) % mod;
+		long long c10 = llround(q[i].real()) % mod;
+		long long c11 = llround(q[i].imag()) % mod;
+		long long r = (c11 * shift30 % mod + (c01 + c10) % mod * shift15 % mod + c00) % mod;
+		C[i] = r < 0 ? r + mod : r;
 	}
 	return C;
 }
 
-int main() {
+// multiplyMod 的最坏输入回归检查：mod = 2^30，两条长 L 的序列系数全为 c = 2^29 - 2^14
+// （拆分后两半均为 ±2^14），乘积的第 k 项为 c^2·min(k + 1, 2L - 1 - k) mod 2^30。
+// L = 2^19 为两段拆分允许的最大长度，L = 10^6 走三段拆分。返回出错的项数
+long long checkWorstCase() {
+	const int mod = 1 << 30;
+	const int c = (1 << 29) - (1 << 14);
+	long long wrong = 0;
+	for (int L : {1 << 19, 1000000}) {
+		vector<int> A(L, c);
+		vector<int> C = multiplyMod(A, A, mod);
+		long long cc = (long long)c * c % mod;
+		for (int k = 0; k < 2 * L - 1; ++k) {
+			if (C[k] != cc * min(k + 1, 2 * L - 1 - k) % mod) {
+				wrong++;
+			}
+		}
+	}
+	return wrong;
+}
+
+// 用法：./fft [--mod p] [--threads k] | ./fft --check（编译需 -pthread）
+// 不带参数时输出精确乘积；带 --mod p 时走拆系数 FFT，输出对 p 取模的乘积（1 <= p <= 2^30）。
+// --threads 指定线程数，默认为 CPU 核数，1 即单线程；结果与线程数无关。
+// --check 运行 checkWorstCase，全部正确时输出 ok 并返回 0
+int main(int argc, char * argv[]) {
+	long long mod = 0;
+	int threads = 0;
+	bool bad = false, check = false;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (arg == "--check") {
+			check = true;
+		} else if (arg == "--mod" && i + 1 < argc) {
+			mod = atoll(argv[++i]);
+			bad |= mod < 1 || mod > (1LL << 30);
+		} else if (arg == "--threads" && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+			bad |= threads < 1;
+		} else {
+			bad = true;
+		}
+	}
+	if (bad) {
+		cerr << "Usage: ./fft [--mod p] [--threads k] | ./fft --check  (1 <= p <= 2^30)" << endl;
+		return 1;
+	}
+	pool.resize(threads > 0 ? threads : max(1u, thread::hardware_concurrency()));
+	
+	if (check) {
+		long long wrong = checkWorstCase();
+		cout << (wrong == 0 ? "ok" : "FAILED: " + to_string(wrong) + " wrong coefficients") << endl;
+		return wrong == 0 ? 0 : 1;
+	}
+	
+	ios::sync_with_stdio(false);
+	cin.tie(nullptr);
+	
 	int n, m;
 	cin >> n >> m;
 	
@@ -92,7 +977,13 @@ int main() {
 	reverse(F.begin(), F.end());
 	reverse(G.begin(), G.end());
 	
-	vector<long long> H = multiply(F, G);
+	vector<long long> H;
+	if (mod > 0) {
+		vector<int> R = multiplyMod(F, G, (int)mod);
+		H.assign(R.begin(), R.end());
+	} else {
+		H = multiply(F, G);
+	}
 	
 	for (int i = (int)H.size() - 1; i >= 0; --i) {
 		cout << H[i];
@@ -101,4 +992,4 @@ int main() {
 		}
 	}
 	return 0;
-}
+}
\ No newline at end of file